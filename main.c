@@ -1,9 +1,18 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 #include <string.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
@@ -19,11 +28,77 @@
 #define MAX_GUESSED_WORDS	   64
 #define MAX_WORDS			   130000
 #define MAX_WORD_SIZE		   25
+#define MAX_ACCENTED_WORDS	  8192
 
 #define NUM_AVAILABLE_CHARS	 10
+#define MAX_BLANKS			  2
 
 #define TIME_MAX				120
 
+#define LETTER_INVALID_BIT	  (1u << 31)
+#define LETTER_REMOVED_BIT	  (1u << 30)
+
+#define MAX_SUGGESTIONS		 3
+#define MAX_SUGGESTION_DISTANCE 2
+
+#define TEXTS_DIR			   "./assets/texts/"
+#define USER_WORDS_FILE		 "user.txt"
+#define OVERLAY_FILE			"overlay.txt"
+#define OVERLAY_POLL_MS		 1000
+#define OVERLAY_COMPACT_LINES   64
+
+#define HISTORY_DIR			 "./history/"
+#define HISTORY_DEFAULT_TOP	 10
+
+#define FONT_ATLAS_FILE		 "./assets/fonts/atlas.bin"
+#define FONT_ATLAS_MAGIC		"PFA1"
+#define FONT_ATLAS_WIDTH		1024
+#define FONT_ATLAS_FIRST_CHAR   32
+#define FONT_ATLAS_LAST_CHAR	126
+#define FONT_ATLAS_NUM_GLYPHS   (FONT_ATLAS_LAST_CHAR - FONT_ATLAS_FIRST_CHAR + 1 + 12)
+
+#define BENCH_DEFAULT_FRAMES	500
+#define BENCH_WARMUP_FRAMES	 10
+#define BENCH_INDEX_REPEAT	  20
+#define BENCH_ROUNDS			20000
+
+#define METRICS_EXPORT_MS	   5000
+#define LATENCY_SUB_BITS		3
+#define LATENCY_SUB_BUCKETS	 (1 << LATENCY_SUB_BITS)
+#define NUM_LATENCY_BUCKETS	 ((32 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+#define LOGIC_TICK_MS		   10
+#define RENDER_FRAMES		   3
+#define RENDER_FRESH_BIT		4
+#define GAME_THREAD_EVENTS	  256
+
+#define OPPONENT_FRAME_BUDGET_US	1000
+#define OPPONENT_CHECK_INTERVAL	 128
+#define OPPONENT_MAX_FOUND		  256
+#define OPPONENT_WORD_TIME_MS	   3000
+
+#define FEED_SHM_NAME		   "/paroliere"
+#define FEED_MAGIC			  0x50524631
+#define FEED_SLOTS			  1024
+#define FEED_SNAPSHOT_MS		1000
+
+#define JOBS_MAX_WORKERS		64
+#define JOBS_QUEUE_SIZE		 4096
+#define JOB_MAX_DEPENDENTS	  16
+#define INDEX_CHUNK_WORDS	   8192
+
+#define QUERY_MAX_SIZE		  100
+
+#define SIM_DEFAULT_ROUNDS	  100000
+#define SIM_DEFAULT_VOWELS	  4
+#define SIM_DEFAULT_SKILL	   30
+#define SIM_DEFAULT_PACE		4
+#define SIM_ROUNDS_PER_CHUNK	64
+#define SIM_CHUNKS_PER_THREAD   16
+#define SIM_MAX_SCORE		   1024
+#define SIM_SHORT_WORD_SIZE	 4
+#define SIM_HISTOGRAM_BUCKET	10
+
 #define PRESSED_KEY event.key.keysym.sym
 
 #define EXPAND_COLOR(color) color.r, color.g, color.b, color.a
@@ -45,6 +120,10 @@ const SDL_Color COLOR_TEXT_NORMAL = {0, 255, 255, 255};
 const SDL_Color COLOR_TEXT_TITLE = {255, 255, 0, 255};
 const SDL_Color COLOR_TEXT_CENTERED = {0, 255, 0, 255};
 
+// points given for a word based on its length, longer words use the last entry
+const int POINTS_BY_LENGTH[] = {0, 0, 1, 1, 1, 2, 3, 5, 11};
+#define NUM_POINTS_BY_LENGTH (sizeof(POINTS_BY_LENGTH)/sizeof(int))
+
 const char *vocals = "AEIOU";
 const char *consonants = "BCDFGHLMNPQRSTVZ";
 
@@ -56,6 +135,40 @@ typedef enum {
 	NUM_FONTS
 } fonts_t;
 
+// files and sizes of the fonts
+const char *FONT_FILES[NUM_FONTS] = {
+	"Roboto-Light.ttf",
+	"Roboto-Regular.ttf",
+	"Roboto-Bold.ttf",
+	"Seven-Segment.ttf",
+};
+const int FONT_SIZES[NUM_FONTS] = {35, 50, 70, 100};
+
+// letter of the alphabet of every latin-1 character with the accents removed, 0 for the other characters
+const char LETTER_OF[256] = {
+	['A'] = 'A', ['B'] = 'B', ['C'] = 'C', ['D'] = 'D', ['E'] = 'E', ['F'] = 'F', ['G'] = 'G', ['H'] = 'H', ['I'] = 'I',
+	['J'] = 'J', ['K'] = 'K', ['L'] = 'L', ['M'] = 'M', ['N'] = 'N', ['O'] = 'O', ['P'] = 'P', ['Q'] = 'Q', ['R'] = 'R',
+	['S'] = 'S', ['T'] = 'T', ['U'] = 'U', ['V'] = 'V', ['W'] = 'W', ['X'] = 'X', ['Y'] = 'Y', ['Z'] = 'Z', ['a'] = 'A',
+	['b'] = 'B', ['c'] = 'C', ['d'] = 'D', ['e'] = 'E', ['f'] = 'F', ['g'] = 'G', ['h'] = 'H', ['i'] = 'I', ['j'] = 'J',
+	['k'] = 'K', ['l'] = 'L', ['m'] = 'M', ['n'] = 'N', ['o'] = 'O', ['p'] = 'P', ['q'] = 'Q', ['r'] = 'R', ['s'] = 'S',
+	['t'] = 'T', ['u'] = 'U', ['v'] = 'V', ['w'] = 'W', ['x'] = 'X', ['y'] = 'Y', ['z'] = 'Z',
+	[0xC0] = 'A', [0xC1] = 'A', [0xC2] = 'A', [0xC3] = 'A', [0xC4] = 'A', [0xC5] = 'A',
+	[0xC7] = 'C', [0xC8] = 'E', [0xC9] = 'E', [0xCA] = 'E', [0xCB] = 'E', [0xCC] = 'I',
+	[0xCD] = 'I', [0xCE] = 'I', [0xCF] = 'I', [0xD1] = 'N', [0xD2] = 'O', [0xD3] = 'O',
+	[0xD4] = 'O', [0xD5] = 'O', [0xD6] = 'O', [0xD9] = 'U', [0xDA] = 'U', [0xDB] = 'U',
+	[0xDC] = 'U', [0xDD] = 'Y', [0xE0] = 'A', [0xE1] = 'A', [0xE2] = 'A',
+	[0xE3] = 'A', [0xE4] = 'A', [0xE5] = 'A', [0xE7] = 'C', [0xE8] = 'E', [0xE9] = 'E',
+	[0xEA] = 'E', [0xEB] = 'E', [0xEC] = 'I', [0xED] = 'I', [0xEE] = 'I', [0xEF] = 'I',
+	[0xF1] = 'N', [0xF2] = 'O', [0xF3] = 'O', [0xF4] = 'O', [0xF5] = 'O', [0xF6] = 'O',
+	[0xF9] = 'U', [0xFA] = 'U', [0xFB] = 'U', [0xFC] = 'U', [0xFD] = 'Y', [0xFF] = 'Y',
+};
+
+// accented italian letters in latin-1, baked after the printable ascii characters
+const Uint8 FONT_ATLAS_EXTRA_CHARS[] = {
+	0xC0, 0xC8, 0xC9, 0xCC, 0xD2, 0xD9,
+	0xE0, 0xE8, 0xE9, 0xEC, 0xF2, 0xF9,
+};
+
 typedef enum {
 	TEXT_TYPE_MAIN_TITLE,
 	TEXT_TYPE_SECONDARY_TITLE,
@@ -81,22 +194,357 @@ typedef enum {
 	NUM_AUDIO
 } audios_t;
 
+typedef enum {
+	HISTORY_RACK,
+	HISTORY_SCORE,
+	HISTORY_TIME,
+	HISTORY_GUESSED_END,
+	HISTORY_GUESSED,
+	HISTORY_GUESSED_AT,
+	HISTORY_MISSED_END,
+	HISTORY_MISSED,
+	NUM_HISTORY_COLUMNS
+} historyColumns_t;
+
+// files and value sizes of the history columns, every round appends one value
+// to the fixed columns and its words to the variable ones, whose ends are
+// stored in the *_END columns
+const char *HISTORY_FILES[NUM_HISTORY_COLUMNS] = {
+	"rack.col",
+	"score.col",
+	"time.col",
+	"guessed_end.col",
+	"guessed.col",
+	"guessed_at.col",
+	"missed_end.col",
+	"missed.col",
+};
+const size_t HISTORY_SIZES[NUM_HISTORY_COLUMNS] = {
+	NUM_AVAILABLE_CHARS,
+	sizeof(Sint32),
+	sizeof(Sint64),
+	sizeof(Uint32),
+	sizeof(Uint32),
+	sizeof(Uint16),
+	sizeof(Uint32),
+	sizeof(Uint32),
+};
+
+typedef enum {
+	COUNTER_VALIDATIONS,
+	COUNTER_ACCEPTED,
+	COUNTER_REJECTED,
+	COUNTER_FRAMES,
+	NUM_COUNTERS
+} counters_t;
+
+typedef enum {
+	LATENCY_CHECK_WORD,
+	LATENCY_FRAME,
+	LATENCY_SOLVER,
+	LATENCY_SUGGESTIONS,
+	LATENCY_ASSET_LOAD,
+	LATENCY_WORKING_SET,
+	NUM_LATENCIES
+} latencies_t;
+
+// names and descriptions of the exported metrics
+const char *COUNTER_NAMES[NUM_COUNTERS][2] = {
+	{"paroliere_validations_total", "Words submitted for validation."},
+	{"paroliere_accepted_words_total", "Submitted words accepted."},
+	{"paroliere_rejected_words_total", "Submitted words rejected."},
+	{"paroliere_frames_total", "Frames rendered."},
+};
+const char *LATENCY_NAMES[NUM_LATENCIES][2] = {
+	{"paroliere_check_word_seconds", "Time taken by checkWordAndPlay."},
+	{"paroliere_frame_seconds", "Time taken to draw and present a frame."},
+	{"paroliere_solver_seconds", "Time taken to find the longest valid word."},
+	{"paroliere_suggestions_seconds", "Time taken to find the suggestions for a rejected word."},
+	{"paroliere_asset_load_seconds", "Time taken to load an asset."},
+	{"paroliere_working_set_seconds", "Time taken to collect the words of the rack."},
+};
+
+typedef struct {
+	SDL_atomic_t counters[NUM_COUNTERS];
+	// log-linear buckets of microseconds, every power of two is split in LATENCY_SUB_BUCKETS
+	SDL_atomic_t latencies[NUM_LATENCIES][NUM_LATENCY_BUCKETS];
+} metrics_t;
+
+// updated from every thread without locks
+metrics_t metrics;
+
+typedef enum {
+	MEMORY_DICTIONARY,
+	MEMORY_FONTS,
+	MEMORY_AUDIO,
+	MEMORY_TEXT,
+	MEMORY_WORKING_SET,
+	MEMORY_JOBS,
+	NUM_MEMORY_USES
+} memoryUses_t;
+
+const char *MEMORY_NAMES[NUM_MEMORY_USES] = {
+	"dictionary",
+	"fonts",
+	"audio",
+	"text",
+	"working-set",
+	"jobs",
+};
+
+typedef struct {
+	// bytes used by every subsystem, now and at most, 64 bit so they don't wrap at 2 GB
+	SDL_SpinLock lock;
+	Sint64 current[NUM_MEMORY_USES];
+	Sint64 peak[NUM_MEMORY_USES];
+	// in bytes, 0 without a budget, the warning is given once every time it's exceeded
+	Sint64 budgets[NUM_MEMORY_USES];
+	bool overBudget[NUM_MEMORY_USES];
+	Sint64 residentBudget;
+} memory_t;
+
+// the allocations of a subsystem start with their size, so they can be untracked when freed
+typedef union {
+	size_t size;
+	Uint64 align;
+	void *pointer;
+	long double number;
+} memoryHeader_t;
+
+memory_t memory;
+
 typedef enum {
 	LAST_WORD_NONE,
 	LAST_WORD_VALID,
 	LAST_WORD_INVALID,
 } lastWord_t;
 
+typedef enum {
+	FEED_STATE,
+	FEED_RACK,
+	FEED_TIME_LEFT,
+	FEED_POINTS,
+	FEED_OPPONENT_POINTS,
+	FEED_CURRENT_WORD,
+	FEED_LAST_WORD,
+	FEED_ACCEPTED,
+	FEED_LONGEST_WORD,
+	NUM_FEED_EVENTS
+} feedEvents_t;
+
+typedef struct {
+	// what the spectators show, only fixed size types as it is shared between processes
+	Sint32 state;
+	char rack[NUM_AVAILABLE_CHARS+1];
+	Sint32 timeLeft;
+	Sint32 points;
+	// -1 without an opponent
+	Sint32 opponentPoints;
+	char currentWord[MAX_WORD_SIZE];
+	Sint32 lastWordT;
+	char guessedWords[MAX_GUESSED_WORDS][MAX_WORD_SIZE];
+	Sint32 guessedWordsNum;
+	// empty until the search ends
+	char longestWord[MAX_WORD_SIZE];
+	Sint32 longestWordReady;
+} feedState_t;
+
+typedef struct {
+	// number of the event plus one, 0 while the slot is written
+	SDL_atomic_t seq;
+	Sint32 type;
+	Sint32 value;
+	char text[MAX_WORD_SIZE];
+} feedSlot_t;
+
+typedef struct {
+	Uint32 magic;
+	// number of events published, the event n is in slots[n % FEED_SLOTS]
+	SDL_atomic_t head;
+	feedSlot_t slots[FEED_SLOTS];
+
+	// the whole state, for the spectators that join late or fall behind
+	// the version is odd while it is written, next is the first event after it
+	SDL_atomic_t snapshotVersion;
+	Uint32 snapshotNext;
+	feedState_t snapshot;
+} feed_t;
+
+typedef struct job_s {
+	// run on a worker, then complete is called on the game thread with an SDL event
+	void (*run)(void *data);
+	void (*complete)(void *data);
+	void *data;
+
+	// dependencies left, plus one until the job is submitted
+	SDL_atomic_t unfinished;
+	SDL_atomic_t done;
+
+	// jobs waiting for this one, protected by the lock, none is added once it's finished
+	SDL_SpinLock lock;
+	struct job_s *dependents[JOB_MAX_DEPENDENTS];
+	size_t numDependents;
+	bool finished;
+} job_t;
+
+typedef struct {
+	// the owner takes jobs from the bottom, the other workers steal from the top
+	SDL_SpinLock lock;
+	job_t *jobs[JOBS_QUEUE_SIZE];
+	int top, bottom;
+} jobQueue_t;
+
+typedef struct {
+	struct jobPool_s *pool;
+	int id;
+	SDL_Thread *thread;
+} jobWorker_t;
+
+typedef struct jobPool_s {
+	int numWorkers;
+	jobWorker_t workers[JOBS_MAX_WORKERS];
+	jobQueue_t queues[JOBS_MAX_WORKERS];
+	// counts the queued jobs, the idle workers sleep on it
+	SDL_sem *available;
+	// the threads waiting for a job sleep here, woken when a job is queued or done
+	SDL_mutex *waitLock;
+	SDL_cond *waitCond;
+	SDL_atomic_t waiters;
+	SDL_atomic_t nextQueue;
+	SDL_atomic_t quit;
+	// type of the SDL events that signal a completed job
+	Uint32 eventType;
+} jobPool_t;
+
+typedef struct {
+	// position in the atlas and horizontal advance of a glyph
+	Uint16 x, y, w, h;
+	Sint16 advance;
+} glyph_t;
+
+typedef struct {
+	// the atlas is decoded in a surface and uploaded to a texture once there is a renderer
+	SDL_Surface *surface;
+	SDL_Texture *texture;
+	glyph_t glyphs[NUM_FONTS][FONT_ATLAS_NUM_GLYPHS];
+	// glyph of every latin-1 character, unknown characters are shown as '?'
+	Uint8 glyphOf[256];
+} fontAtlas_t;
+
+// 4 bits for the count of every letter, A-P in the low half and Q-Z in the high one
+typedef struct {
+	Uint64 low, high;
+} letterCounts_t;
+
+typedef struct {
+	Uint32 id;
+	// utf-8, as in the word lists
+	char text[MAX_WORD_SIZE];
+} accentedWord_t;
+
+typedef struct {
+	// words of the lists of the game, the next ones were added by the user
+	size_t numListWords;
+	size_t wordsCapacity, accentedCapacity;
+	// every word of the dictionary by its text, with its copies, built when the overlay is applied
+	Uint32 *table;
+	size_t tableSize, tableUsed;
+	// how much of the overlay was applied, a compacted overlay is a new file
+	off_t offset;
+	ino_t inode;
+	// lines that changed the dictionary since the last compaction
+	size_t pending;
+} overlay_t;
+
+typedef struct {
+	job_t job;
+	bool running;
+	// the new files, prepared by the game thread so the job doesn't read the dictionary
+	char *userWords, *removed;
+	size_t userSize, removedSize;
+	// the lines appended after this offset weren't compacted, they are kept
+	off_t offset;
+} overlayCompaction_t;
+
+typedef struct {
+	job_t job;
+	// a copy of the round, made by the game thread so the job doesn't read the game
+	char rack[NUM_AVAILABLE_CHARS];
+	Sint32 score;
+	Sint64 startTime;
+	Uint32 guessedIds[MAX_GUESSED_WORDS];
+	Uint16 guessedAt[MAX_GUESSED_WORDS];
+	size_t guessedNum;
+	// freed by the job
+	Uint32 *missed;
+	size_t missedNum;
+} historyRound_t;
+
 typedef struct {
 	TTF_Font *fonts[NUM_FONTS];
 	int fontSizes[NUM_FONTS];
+	bool useAtlas;
+	fontAtlas_t atlas;
 
 	Mix_Chunk *sounds[NUM_AUDIO];
 
-	char words[MAX_WORDS][MAX_WORD_SIZE];
+	// the words are normalized to upper case letters without accents, one byte each
+	char (*words)[MAX_WORD_SIZE];
+	// how the words with accents are written, sorted by id
+	accentedWord_t *accented;
+	size_t numAccented;
+	// bit i is set if the word contains the i-th letter of the alphabet
+	Uint32 *wordMasks;
+	// how many times the word contains every letter, for the games where the letters are used once
+	letterCounts_t *wordCounts;
 	size_t numWords;
+	// words added and removed by the user without editing the lists
+	overlay_t overlay;
 } assets_t;
 
+typedef struct {
+	job_t job;
+	assets_t *assets;
+	size_t start, end;
+} indexChunk_t;
+
+typedef struct {
+	job_t job;
+	assets_t *assets;
+	jobPool_t *jobs;
+} dictionaryTask_t;
+
+typedef struct {
+	bool enabled;
+	// percentage of the solutions found, also sets how fast words are written
+	int skill;
+	Uint32 rng;
+
+	// next word of the working set to examine, the search ends at the end of the set
+	size_t cursor;
+	// words found but not written yet
+	size_t found[OPPONENT_MAX_FOUND];
+	size_t numFound, numCandidates;
+
+	char guessedWords[MAX_GUESSED_WORDS][MAX_WORD_SIZE];
+	size_t guessedWordsNum;
+	int points;
+	Uint32 nextWordTicks;
+
+	// time spent searching in every frame
+	Uint64 totalStepUs, maxStepUs;
+	size_t numSteps, overBudgetSteps;
+} opponent_t;
+
+typedef struct {
+	// ids of the words made only of rack letters, in dictionary order
+	Uint32 *ids;
+	size_t num;
+	// open addressing table of the positions in ids plus one, by hash of the word
+	Uint32 *table;
+	size_t tableSize;
+} workingSet_t;
+
 typedef enum {
 	GAME_STATE_LOADING,
 	GAME_STATE_CHOOSING_LETTERS,
@@ -105,89 +553,452 @@ typedef enum {
 	GAME_STATE_CLOSE
 } gameState_t;
 
+const char *GAME_STATE_NAMES[] = {
+	"loading",
+	"choosing letters",
+	"running",
+	"ended",
+	"close",
+};
+
 typedef struct {
 	gameState_t state;
 
 	int points;
 	char guessedWords[MAX_GUESSED_WORDS][MAX_WORD_SIZE];
+	// dictionary id and second of the round of every guessed word
+	Uint32 guessedIds[MAX_GUESSED_WORDS];
+	Uint16 guessedAt[MAX_GUESSED_WORDS];
 	size_t guessedWordsNum;
 
 	lastWord_t lastWordT;
 
+	// closest valid words to the last rejected one
+	char suggestions[MAX_SUGGESTIONS][MAX_WORD_SIZE];
+	size_t suggestionsNum;
+
 	char currentWord[MAX_WORD_SIZE];
 	size_t currentWordSize;
 
 	char validCharList[NUM_AVAILABLE_CHARS+1];
+	Uint32 rackMask;
+	// blanks, shown as '?', allowed and in the rack; every one stands for a letter not in the rack
+	int maxBlanks, blanks;
+	// every letter of the rack can be used only as many times as it was generated
+	bool multiset;
+	letterCounts_t rackCounts;
+	// the only words that can be played in the round
+	workingSet_t workingSet;
+
+	opponent_t opponent;
 
-	time_t timeLeft, lastTime;
+	time_t timeLeft, lastTime, startTime;
 
 	int screen_width, screen_height;
 
+	const char *metricsPath;
+
+	// shared memory where the round is published for the spectators
+	feed_t *feed;
+	feedState_t published;
+	Uint32 nextSnapshot;
+
+	// longest valid word as it is written, searched by a job when the game ends
+	jobPool_t *jobs;
+	job_t longestWordJob;
+	char longestWord[MAX_WORD_SIZE];
+	bool longestWordReady;
+
+	// the overlay is read while playing, and compacted by a job
+	Uint32 nextOverlayPoll;
+	overlayCompaction_t compaction;
+
+	// the ended round is written to the history by a job, the files are synced
+	historyRound_t savedRound;
+
 	assets_t assets;
 } game_t;
 
-char randomVocal(void);
-char randomConsonant(void);
+typedef struct {
+	// the fonts to draw with, they don't change after loading
+	const assets_t *assets;
+
+	// only what is drawn of the game
+	gameState_t state;
+	int screen_width, screen_height;
+	time_t timeLeft;
+	int points;
+	lastWord_t lastWordT;
+	char suggestions[MAX_SUGGESTIONS][MAX_WORD_SIZE];
+	size_t suggestionsNum;
+	char currentWord[MAX_WORD_SIZE];
+	char validCharList[NUM_AVAILABLE_CHARS+1];
+	int maxBlanks, blanks;
+	bool multiset;
+	bool opponentEnabled;
+	int opponentPoints;
+	char longestWord[MAX_WORD_SIZE];
+	bool longestWordReady;
+} frame_t;
+
+typedef struct {
+	SDL_Thread *thread;
+	game_t *game;
+
+	// the events read by the main thread, handled in order by the game thread,
+	// the semaphores count the queued ones and the free room
+	SDL_Event events[GAME_THREAD_EVENTS];
+	size_t head, tail;
+	SDL_SpinLock eventsLock;
+	SDL_sem *pending, *room;
+	// set when the game thread returns, nothing takes the events anymore
+	SDL_atomic_t stopped;
+
+	// the game thread writes the back frame and the main thread draws its own one,
+	// latest is the last complete frame, with RENDER_FRESH_BIT until it's taken
+	frame_t frames[RENDER_FRAMES];
+	int back;
+	SDL_atomic_t latest;
+	// only the frames that changed are published, with an event for the main thread
+	frame_t published;
+	Uint32 frameEvent;
+} gameThread_t;
+
+typedef struct {
+	char rack[NUM_AVAILABLE_CHARS+1];
+	Uint32 count;
+	Sint64 total;
+} historyRack_t;
+
+typedef struct {
+	size_t rounds;
+	int threads;
+	int numChars;
+	int vowels;
+	int skill;
+	int pace;
+	int timeMax;
+	bool multiset;
+	int points[MAX_WORD_SIZE+1];
+	size_t numPoints;
+	Uint32 seed;
+} simConfig_t;
+
+typedef struct {
+	size_t rounds;
+	size_t solvable;
+	size_t solutions;
+	size_t wordsFound;
+	size_t scores[SIM_MAX_SCORE+1];
+} simStats_t;
+
+typedef struct {
+	job_t job;
+	const assets_t *assets;
+	const simConfig_t *config;
+	Uint32 start, end;
+	simStats_t stats;
+} simChunk_t;
+
+typedef struct {
+	// runs when every chunk is done
+	job_t job;
+	const simChunk_t *chunks;
+	size_t numChunks;
+	simStats_t *stats;
+} simMerge_t;
+
+typedef struct {
+	// node of a first-child/next-sibling trie, the siblings are in alphabetical order
+	char letter;
+	// id of the word ending here plus one, 0 if no word ends here
+	Uint32 word;
+	Uint32 child, sibling;
+	// last query that reported the word, the same word can be reached by different '*'
+	Uint32 seen;
+	// last query that walked the node, its bits in the visited offsets are stale before
+	Uint32 walked;
+} trieNode_t;
+
+typedef struct {
+	// letters of the word in alphabetical order
+	char signature[MAX_WORD_SIZE];
+	Uint32 id;
+} signature_t;
+
+typedef struct {
+	const assets_t *assets;
+
+	// all the words sorted by signature, the anagrams are next to each other
+	signature_t *signatures;
+	size_t numSignatures;
 
-int getFontWidth(TTF_Font *font, const char *text);
+	trieNode_t *nodes;
+	size_t numNodes, nodesCapacity;
+	Uint32 query;
 
+	// the pattern being matched, and a bit for every node and offset already walked,
+	// as the '*' reach the same node at the same offset in many ways
+	const char *pattern;
+	size_t offsetBytes;
+	Uint8 *visited;
+	size_t visitedSize;
+
+	Uint32 *results;
+	size_t numResults;
+} queryIndex_t;
+
+char randomVocal(void);
+char randomConsonant(void);
+Uint32 nextRandom(Uint32 *state);
+
+jobPool_t *createJobPool(int numWorkers);
+void destroyJobPool(jobPool_t *pool);
+void initJob(job_t *job, void (*run)(void *data), void (*complete)(void *data), void *data);
+void addJobDependency(jobPool_t *pool, job_t *job, job_t *dependency);
+void submitJob(jobPool_t *pool, job_t *job);
+void waitJob(jobPool_t *pool, job_t *job);
+void wakeWaiters(jobPool_t *pool);
+bool pushJob(jobQueue_t *queue, job_t *job);
+job_t *takeJob(jobPool_t *pool, int id);
+void runJob(jobPool_t *pool, job_t *job);
+int jobWorker(void *data);
+void completeJob(const SDL_Event *event);
+
+Uint32 letterMask(const char *word);
+letterCounts_t letterCounts(const char *word);
+Uint32 excessLetters(letterCounts_t word, letterCounts_t rack);
+Uint32 excessHalf(Uint64 word, Uint64 rack);
+Uint32 hashWord(const char *word);
+int countLetters(Uint32 mask);
+Uint8 nextLatin1(const char **text);
+bool normalizeWord(const char *text, char *word, size_t size);
+const char *wordText(const assets_t *assets, size_t id);
+int wordPoints(const int *points, size_t numPoints, size_t len);
+
+int textWidth(const assets_t *assets, fonts_t font, const char *text);
+
+bool canTypeLetter(const game_t *game, char letter);
+void buildWorkingSet(game_t *game);
+Sint32 findRackWord(const game_t *game, const char *word);
 void checkWordAndPlay(game_t *game);
+int editDistance(const char *a, const char *b, int max);
+void findSuggestions(game_t *game, const char *word);
 void findValidWord(const game_t *game, char *word);
+void longestWordJob(void *data);
+void longestWordCompleted(void *data);
+
+int parseGameOptions(game_t *game, int argc, char *argv[]);
+
+void countMetric(counters_t counter);
+int latencyBucket(Uint64 us);
+Uint64 latencyBucketValue(int bucket);
+void observeLatency(latencies_t latency, Uint64 start);
+void exportMetrics(const char *path);
+
+void trackMemory(memoryUses_t use, Sint64 bytes);
+void readMemory(Sint64 current[NUM_MEMORY_USES], Sint64 peak[NUM_MEMORY_USES]);
+void *allocMemory(memoryUses_t use, size_t size);
+void *reallocMemory(memoryUses_t use, void *pointer, size_t size);
+void freeMemory(memoryUses_t use, void *pointer);
+Sint64 residentMemory(void);
+Sint64 peakResidentMemory(void);
+void reportMemory(const char *when);
+int parseMemoryBudget(const char *budget);
+
+feed_t *openFeed(void);
+void publishEvent(feed_t *feed, feedEvents_t type, Sint32 value, const char *text);
+void publishValue(feed_t *feed, feedEvents_t type, Sint32 *published, Sint32 value);
+void publishText(feed_t *feed, feedEvents_t type, char *published, size_t size, const char *text);
+void publishFeed(game_t *game);
+Uint32 feedLoad(const SDL_atomic_t *atomic);
+bool readFeedSnapshot(const feed_t *feed, feedState_t *state, Uint32 *next);
+void applyFeedEvent(feedState_t *state, const feedSlot_t *slot);
+bool followFeed(const feed_t *feed, feedState_t *state, Uint32 *next, bool synced);
+void showFeedState(game_t *game, const feedState_t *state);
+int runSpectator(void);
+
+void startOpponent(game_t *game);
+void restartOpponentSearch(opponent_t *opponent);
+void stepOpponent(game_t *game);
+void printOpponentReport(const opponent_t *opponent);
+
+bool writeAll(int fd, const void *data, size_t size);
+bool replaceFile(const char *path, const char *data, size_t size, const char *more, size_t moreSize);
+void saveRound(game_t *game);
+void saveRoundJob(void *data);
+void *mapHistoryColumn(historyColumns_t column, size_t *size);
+void unmapHistory(void *columns[NUM_HISTORY_COLUMNS], const size_t sizes[NUM_HISTORY_COLUMNS]);
+int compareRackAverage(const void *a, const void *b);
+int runHistoryQuery(int argc, char *argv[]);
 
 void loadFont(assets_t * const assets, fonts_t font, const char *name, size_t size);
+Uint16 fontAtlasChar(size_t glyph);
+void indexFontAtlas(fontAtlas_t *atlas);
+bool loadFontAtlas(assets_t * const assets);
+void uploadFontAtlas(assets_t * const assets, SDL_Renderer *renderer);
+int runFontBaking(void);
 void loadAudio(assets_t * const assets, audios_t audioId, const char *name);
 void loadText(assets_t * const assets, const char *name);
-
-void loadAssets(assets_t * const assets);
+void loadDictionary(assets_t * const assets, jobPool_t *jobs);
+void loadDictionaryJob(void *data);
+void freeDictionary(assets_t * const assets);
+void indexDictionary(assets_t * const assets, jobPool_t *jobs);
+void indexChunkJob(void *data);
+void buildWordTable(assets_t * const assets);
+void insertWord(assets_t * const assets, Uint32 id);
+Sint32 findDictionaryWord(const assets_t *assets, const char *word);
+bool userWord(const char *text, char *word);
+bool applyOverlayWord(assets_t * const assets, bool add, const char *text);
+void loadUserWords(assets_t * const assets);
+bool readOverlay(assets_t * const assets);
+void pollOverlay(game_t *game);
+void compactOverlay(game_t *game);
+void compactOverlayJob(void *data);
+void overlayCompacted(void *data);
+int runOverlayEdit(int argc, char *argv[]);
+
+void loadFonts(assets_t * const assets);
+void loadAssets(assets_t * const assets, jobPool_t *jobs);
 
 void freeAudio(Mix_Chunk *sounds[NUM_AUDIO]);
 
 void playSound(Mix_Chunk *sound);
 
 void renderRect(SDL_Renderer *renderer, SDL_Color color, int x, int y, int width, int height);
-void renderText(SDL_Renderer *renderer, const game_t *game, SDL_Color color, const char *text, TTF_Font *font, alignment_t alignment, int x, int y);
-void renderTextType(SDL_Renderer *renderer, const game_t *game, textTypes_t type, const char *text);
-void renderBorder(SDL_Renderer *renderer, const game_t *game, const SDL_Color color);
-void renderTimeLeft(SDL_Renderer *renderer, const game_t *game);
-
-void renderLoadingState(SDL_Renderer *renderer, const game_t *game);
-void renderChoosingLettersState(SDL_Renderer *renderer, const game_t *game);
-void renderRunningState(SDL_Renderer *renderer, const game_t *game);
-void renderEndedState(SDL_Renderer *renderer, const game_t *game);
-void renderGame(SDL_Renderer *renderer, const game_t *game);
-
-int main(void) {
-	srand(time(NULL));
-
+void renderText(SDL_Renderer *renderer, const frame_t *frame, SDL_Color color, const char *text, fonts_t font, alignment_t alignment, int x, int y);
+void renderTextType(SDL_Renderer *renderer, const frame_t *frame, textTypes_t type, const char *text);
+void renderBorder(SDL_Renderer *renderer, const frame_t *frame, const SDL_Color color);
+void renderTimeLeft(SDL_Renderer *renderer, const frame_t *frame);
+
+void renderLoadingState(SDL_Renderer *renderer, const frame_t *frame);
+void renderChoosingLettersState(SDL_Renderer *renderer, const frame_t *frame);
+void renderRunningState(SDL_Renderer *renderer, const frame_t *frame);
+void renderEndedState(SDL_Renderer *renderer, const frame_t *frame);
+void renderGame(SDL_Renderer *renderer, const frame_t *frame);
+void snapshotGame(const game_t *game, frame_t *frame);
+void publishFrame(gameThread_t *thread, const game_t *game);
+int takeFrame(gameThread_t *thread, int front);
+void pushGameEvent(gameThread_t *thread, const SDL_Event *event);
+void popGameEvent(gameThread_t *thread, SDL_Event *event);
+int gameThread(void *data);
+bool startGameThread(gameThread_t *thread, game_t *game);
+
+int initLibraries(void);
+
+void setupBenchGame(game_t *game, gameState_t state);
+int runRenderBenchmark(int argc, char *argv[]);
+int runJobsBenchmark(void);
+
+void sortLetters(const char *word, char *signature);
+int compareSignatures(const void *a, const void *b);
+int compareIds(const void *a, const void *b);
+Uint32 addTrieChild(queryIndex_t *index, Uint32 node, char letter);
+void buildQueryIndex(queryIndex_t *index, const assets_t *assets);
+void findAnagrams(queryIndex_t *index, const char *letters);
+void matchPattern(queryIndex_t *index, Uint32 node, const char *pattern);
+bool runQuery(queryIndex_t *index, char *query);
+int runQueries(int argc, char *argv[]);
+
+int parseSimConfig(simConfig_t *config, int argc, char *argv[]);
+void simulateRound(const assets_t *assets, const simConfig_t *config, Uint32 round, simStats_t *stats);
+void simulationJob(void *data);
+void mergeSimulationJob(void *data);
+void printSimStats(const simConfig_t *config, const simStats_t *stats, double seconds);
+int runSimulation(int argc, char *argv[]);
+
+int initLibraries(void)
+{
 	// initializing general library
 	if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
 		fprintf(stderr, "SDL_Init Error: %s\n", SDL_GetError());
-		return EXIT_FAILURE;
-	}
-
-	// initializing font library
-	if(TTF_Init() != 0) {
-		fprintf(stderr, "TTF_Init Error: %s\n", TTF_GetError());
-		return EXIT_FAILURE;
+		return -1;
 	}
 
 	// initialize audio library
 	if(Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) != 0) {
 		fprintf(stderr, "Mix_OpenAudio Error: %s\n", Mix_GetError());
-		return EXIT_FAILURE;
+		return -1;
 	}
 
 	// set max volume
 	Mix_Volume(-1, MIX_MAX_VOLUME/10);
 
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	srand(time(NULL));
+
+	// run the self-play simulator instead of the game
+	if(argc > 1 && strcmp(argv[1], "--simulate") == 0) {
+		return runSimulation(argc-2, argv+2);
+	}
+
+	// query the history of the played rounds
+	if(argc > 1 && strcmp(argv[1], "--history") == 0) {
+		return runHistoryQuery(argc-2, argv+2);
+	}
+
+	// rasterize the fonts in the atlas, done at build time
+	if(argc > 1 && strcmp(argv[1], "--bake-fonts") == 0) {
+		return runFontBaking();
+	}
+
+	// benchmark the job pool with different numbers of workers
+	if(argc > 1 && strcmp(argv[1], "--bench-jobs") == 0) {
+		return runJobsBenchmark();
+	}
+
+	// search the dictionary by anagram or pattern
+	if(argc > 1 && strcmp(argv[1], "--query") == 0) {
+		return runQueries(argc-2, argv+2);
+	}
+
+	// follow the round of a game started with --broadcast
+	if(argc > 1 && strcmp(argv[1], "--spectate") == 0) {
+		return runSpectator();
+	}
+
+	// add and remove words of the dictionary, also while playing
+	if(argc > 2 && strcmp(argv[1], "--overlay") == 0) {
+		return runOverlayEdit(argc-2, argv+2);
+	}
+
+	// benchmark the renderers without a window
+	if(argc > 1 && strcmp(argv[1], "--bench-render") == 0) {
+		return runRenderBenchmark(argc-2, argv+2);
+	}
+
+	if(initLibraries() != 0) {
+		return EXIT_FAILURE;
+	}
+
 	// creating main object
 	game_t game = {0};
 	game.timeLeft = TIME_MAX;
 	game.screen_width = SCREEN_DEFAULT_WIDTH;
 	game.screen_height = SCREEN_DEFAULT_HEIGHT;
 
+	if(parseGameOptions(&game, argc-1, argv+1) != 0) {
+		fprintf(stderr, "Usage: main [--opponent SKILL] [--metrics FILE] [--broadcast] [--jolly N] [--multiset]\n"
+				"            [--memory-budget NAME=MB]...\n"
+				"       main --spectate\n"
+				"       main --simulate [OPTIONS]\n"
+				"       main --history top|racks|missed [K]\n"
+				"       main --query [LETTERS|PATTERN]...\n"
+				"       main --overlay +WORD|-WORD...\n"
+				"       main --bench-render [FRAMES]\n"
+				"       main --bench-jobs\n"
+				"       main --bake-fonts\n");
+		return EXIT_FAILURE;
+	}
+
+	// workers for the slow tasks, one for every core
+	game.jobs = createJobPool(SDL_GetCPUCount());
+
 	// loading assets
-	loadAssets(&game.assets);
+	loadAssets(&game.assets, game.jobs);
 
 	// creating window
 	SDL_Window *window = SDL_CreateWindow("Paroliere",
@@ -213,851 +1024,4323 @@ int main(void) {
 	// set minimum dimensions for the window
 	SDL_SetWindowMinimumSize(window, SCREEN_MIN_WIDTH, SCREEN_MIN_HEIGHT);
 
-	SDL_Event event;
-	time_t before, actual;
-
-	// main cicle
-	while(game.state != GAME_STATE_CLOSE) {
-
-		if(game.state == GAME_STATE_RUNNING) {
+	// the baked fonts are uploaded once the renderer exists
+	uploadFontAtlas(&game.assets, renderer);
 
-			// decrement the time every second
-			actual = time(NULL);
-			game.timeLeft -= (actual-before);
-			before = actual;
-			// if the time has ended, end the game
-			if(game.timeLeft < 1) {
-				game.state = GAME_STATE_ENDED;
-			}
+	// the game runs on its own thread and this one draws the frames it publishes,
+	// so a slow step of the game doesn't skip them
+	gameThread_t logic = {0};
+	if(!startGameThread(&logic, &game)) {
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		return EXIT_FAILURE;
+	}
 
-			// play the sound, once the "tic" and once the "tac"
-			if(game.lastTime > game.timeLeft) {
-				if(game.lastTime % 2 == 0) {
-					playSound(game.assets.sounds[AUDIO_TIC]);
-				} else {
-					playSound(game.assets.sounds[AUDIO_TAC]);
-				}
+	SDL_Event event;
+	int front = RENDER_FRAMES-1;
+	bool redraw = true;
+
+	// main cicle, until the game thread publishes the closed game
+	for(;;) {
+
+		// sleep until there is a new frame or some input, the game thread handles the input,
+		// the first frame is drawn without waiting
+		bool pending = (redraw ? SDL_PollEvent(&event) : SDL_WaitEvent(&event)) != 0;
+		for(; pending; pending = SDL_PollEvent(&event)) {
+			if(event.type == logic.frameEvent) {
+				redraw = true;
+			} else if(event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED) {
+				// the window shows the frame again, for example after being covered
+				redraw = true;
+			} else if(event.type == SDL_QUIT || event.type == SDL_KEYDOWN ||
+					  (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) ||
+					  event.type == game.jobs->eventType) {
+				// only the events the game handles, the mouse motion would only fill the queue
+				pushGameEvent(&logic, &event);
 			}
+		}
+		if(!redraw) {
+			continue;
+		}
+		redraw = false;
 
-			game.lastTime = game.timeLeft;
-
+		// draw the latest frame of the game
+		Uint64 frameStart = SDL_GetPerformanceCounter();
+		front = takeFrame(&logic, front);
+		if(logic.frames[front].state == GAME_STATE_CLOSE) {
+			break;
 		}
 
-		// repeat for every event
-		while(SDL_PollEvent(&event)) {
+		// clear renderer queue
+		SDL_RenderClear(renderer);
 
-			switch(event.type) {
+		// render all game parts in base of the game state
+		renderGame(renderer, &logic.frames[front]);
 
-			case SDL_QUIT: {
-				// set state when window is closed
-				game.state = GAME_STATE_CLOSE;
-			} break;
+		// call to render the frame
+		SDL_RenderPresent(renderer);
 
-			case SDL_WINDOWEVENT: {
+		// measure the draw plus present, the wait for a new frame is not counted
+		countMetric(COUNTER_FRAMES);
+		observeLatency(LATENCY_FRAME, frameStart);
+	}
+	SDL_WaitThread(logic.thread, NULL);
+	SDL_DestroySemaphore(logic.pending);
+	SDL_DestroySemaphore(logic.room);
 
-				switch(event.window.event) {
+	if(game.metricsPath != NULL) {
+		exportMetrics(game.metricsPath);
+	}
 
-				case SDL_WINDOWEVENT_RESIZED: {
-					// update game window size in case of resize
-					SDL_GetWindowSize(window, &game.screen_width, &game.screen_height);
-				} break;
+	// tell the spectators the game is closed, they keep their mapping until the next game
+	if(game.feed != NULL) {
+		publishFeed(&game);
+		munmap(game.feed, sizeof(feed_t));
+		shm_unlink(FEED_SHM_NAME);
+	}
 
-				default: {
-				} break;
 
-				}
+	// stop the workers, waiting for the running jobs
+	if(game.longestWordJob.run != NULL) {
+		waitJob(game.jobs, &game.longestWordJob);
+	}
+	if(game.compaction.running) {
+		waitJob(game.jobs, &game.compaction.job);
+		overlayCompacted(&game.compaction);
+	}
+	if(game.savedRound.job.run != NULL) {
+		waitJob(game.jobs, &game.savedRound.job);
+	}
+	destroyJobPool(game.jobs);
+	freeMemory(MEMORY_WORKING_SET, game.workingSet.ids);
+	freeMemory(MEMORY_WORKING_SET, game.workingSet.table);
+	freeDictionary(&game.assets);
 
-			} break;
+	// free renderer resources
+	SDL_DestroyRenderer(renderer);
 
-			case SDL_KEYDOWN: {
+	// free window resources
+	SDL_DestroyWindow(window);
 
-				switch(game.state) {
+	// free audio resources
+	freeAudio(game.assets.sounds);
 
-				case GAME_STATE_LOADING: {
-					switch(PRESSED_KEY) {
+	// closing and cleaning TTF, Mixer and SDL libraries 
+	TTF_Quit();
+	Mix_CloseAudio();
+	SDL_Quit();
 
-					// if user has pressed enter the game goes to next phase
-					case SDLK_RETURN: {
-						game.state = GAME_STATE_CHOOSING_LETTERS;
-					} break;
+	return EXIT_SUCCESS;
+}
 
-					// if the user has pressed q the game exits
-					case SDLK_q: {
-						game.state = GAME_STATE_CLOSE;
-					} break;
 
-					default: {
-					} break;
+char randomVocal(void)
+{
+	return vocals[rand()%5];
+}
 
-					}
-				} break;
+char randomConsonant(void)
+{
+	return consonants[rand()%strlen(consonants)];
+}
 
-				case GAME_STATE_CHOOSING_LETTERS: {
+Uint32 nextRandom(Uint32 *state)
+{
+	// xorshift32, used where rand() can't be shared between threads
+	Uint32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
 
-					switch(PRESSED_KEY) {
+Uint32 letterMask(const char *word)
+{
+	Uint32 mask = 0;
+	for(size_t i = 0; word[i] != '\0'; i++) {
+		if(word[i] >= 'A' && word[i] <= 'Z') {
+			mask |= 1u << (word[i] - 'A');
+		} else {
+			// the word can't be typed, so it never matches a rack
+			mask |= LETTER_INVALID_BIT;
+		}
+	}
+	return mask;
+}
 
-					// 1 and 2 to choose types of letters
-					case SDLK_1:
-					case SDLK_2: {
-						char ch;
+letterCounts_t letterCounts(const char *word)
+{
+	letterCounts_t counts = {0, 0};
+	for(size_t i = 0; word[i] != '\0'; i++) {
+		// the other characters are marked by the letter mask
+		if(word[i] < 'A' || word[i] > 'Z') {
+			continue;
+		}
+		int letter = word[i] - 'A';
+		Uint64 *half = letter < 16 ? &counts.low : &counts.high;
+		int shift = (letter % 16) * 4;
+		// saturated, no rack has that many copies of a letter
+		if(((*half >> shift) & 0xF) != 0xF) {
+			*half += (Uint64) 1 << shift;
+		}
+	}
+	return counts;
+}
 
-						// generate random char based on the pressed character
-						if(PRESSED_KEY == SDLK_1) {
-							ch = randomVocal();
-						} else {
-							ch = randomConsonant();
-						}
-						// add the generated character to the list
-						game.validCharList[strlen(game.validCharList)] = ch;
+Uint32 excessHalf(Uint64 word, Uint64 rack)
+{
+	const Uint64 high = 0x8888888888888888ull;
+	const Uint64 bytes = 0x0F0F0F0F0F0F0F0Full;
+	// word - rack in every 4 bits, without borrows between them
+	Uint64 diff = ((word | high) - (rack & ~high)) ^ ((word ^ ~rack) & high);
+	// top bit set where the rack has more letters than the word
+	Uint64 borrow = ((~word & rack) | (~(word ^ rack) & diff)) & high;
+	// borrow * 2 - borrow / 8 fills those 4 bits, without multiplications
+	Uint64 excess = diff & ~((borrow << 1) - (borrow >> 3));
+	// sum of the counts, at most 16*15 so it fits in a byte
+	excess = (excess & bytes) + ((excess >> 4) & bytes);
+	excess += excess >> 32;
+	excess += excess >> 16;
+	excess += excess >> 8;
+	return excess & 0xFF;
+}
 
-						// if the user has selected the type for every letter
-						if(strlen(game.validCharList) == NUM_AVAILABLE_CHARS) {
-							// initialize timer
-							before = time(NULL);
-							// pass to next fase
-							game.state = GAME_STATE_RUNNING;
-						}
+Uint32 excessLetters(letterCounts_t word, letterCounts_t rack)
+{
+	// letters of the word missing from the rack, counting the repeated ones
+	return excessHalf(word.low, rack.low) + excessHalf(word.high, rack.high);
+}
 
-					} break;
+Uint32 hashWord(const char *word)
+{
+	// FNV-1a
+	Uint32 hash = 2166136261u;
+	for(size_t i = 0; word[i] != '\0'; i++) {
+		hash = (hash ^ (Uint8) word[i]) * 16777619u;
+	}
+	return hash;
+}
 
-					default: {
-					} break;
+int countLetters(Uint32 mask)
+{
+	int count = 0;
+	for(; mask != 0; mask &= mask - 1) {
+		count++;
+	}
+	return count;
+}
 
-					}
-				} break;
+Uint8 nextLatin1(const char **text)
+{
+	// decode a utf-8 character, the ones outside of latin-1 become '?'
+	Uint8 c = *(*text)++;
+	if(c < 0x80) {
+		return c;
+	}
+	Uint32 code = c & 0x1F;
+	if((c & 0xE0) != 0xC0) {
+		code = 0x100;
+	}
+	while((**text & 0xC0) == 0x80) {
+		code = (code << 6) | (*(*text)++ & 0x3F);
+	}
+	return code < 0x100 ? code : '?';
+}
 
-				case GAME_STATE_RUNNING: {
+bool normalizeWord(const char *text, char *word, size_t size)
+{
+	// returns if the text had characters outside of ascii
+	bool accented = false;
+	size_t len = 0;
+	while(*text != '\0' && len < size-1) {
+		accented |= (*text & 0x80) != 0;
+		Uint8 c = nextLatin1(&text);
+		if(LETTER_OF[c] != 0) {
+			word[len++] = LETTER_OF[c];
+		} else if(c < 0x80) {
+			word[len++] = c;
+		} else {
+			// not a letter, the word can't be typed
+			word[len++] = '#';
+		}
+	}
+	word[len] = '\0';
+	return accented;
+}
 
-					switch(PRESSED_KEY) {
+const char *wordText(const assets_t *assets, size_t id)
+{
+	// binary search of the few words with accents
+	size_t low = 0, high = assets->numAccented;
+	while(low < high) {
+		size_t mid = low + (high - low) / 2;
+		if(assets->accented[mid].id < id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if(low < assets->numAccented && assets->accented[low].id == id) {
+		return assets->accented[low].text;
+	}
+	return assets->words[id];
+}
 
-					case SDLK_RETURN: {
-						checkWordAndPlay(&game);
-					} break;
+int wordPoints(const int *points, size_t numPoints, size_t len)
+{
+	if(len >= numPoints) {
+		return points[numPoints-1];
+	}
+	return points[len];
+}
 
-					// delete last inserted char if there is any
-					case SDLK_BACKSPACE: {
-						if(game.currentWordSize > 0) {
-							game.currentWord[--game.currentWordSize] = '\0';
-						}
-					} break;
+jobPool_t *createJobPool(int numWorkers)
+{
+	jobPool_t *pool = allocMemory(MEMORY_JOBS, sizeof(jobPool_t));
+	if(pool == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the job pool\n");
+		exit(EXIT_FAILURE);
+	}
+	if(numWorkers < 1) {
+		numWorkers = 1;
+	}
+	if(numWorkers > JOBS_MAX_WORKERS) {
+		numWorkers = JOBS_MAX_WORKERS;
+	}
+	pool->numWorkers = numWorkers;
+	pool->available = SDL_CreateSemaphore(0);
+	pool->waitLock = SDL_CreateMutex();
+	pool->waitCond = SDL_CreateCond();
+	pool->eventType = SDL_RegisterEvents(1);
+	if(pool->available == NULL || pool->waitLock == NULL || pool->waitCond == NULL) {
+		fprintf(stderr, "SDL_CreateSemaphore Error: %s\n", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
 
-					default: {
-						int ch = PRESSED_KEY;
-						// check if ch is a letter
-						if(ch < 127 && isalpha(ch)) {
-							// verify that the inserted word hasn't reached the max length
-							if(game.currentWordSize < MAX_WORD_SIZE) {
-								// check that the charachter is in the available list
-								if(strrchr(game.validCharList, toupper(ch)) != NULL) {
-									// add character to end of word
-									game.currentWord[game.currentWordSize++] = toupper(ch);
-								} else {
-									playSound(game.assets.sounds[AUDIO_INCORRECT]);
-								}
-							} else {
-								playSound(game.assets.sounds[AUDIO_INCORRECT]);
-							}
-						}
-					} break;
+	for(int i = 0; i < numWorkers; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].id = i;
+		pool->workers[i].thread = SDL_CreateThread(jobWorker, "worker", &pool->workers[i]);
+		if(pool->workers[i].thread == NULL) {
+			fprintf(stderr, "SDL_CreateThread Error: %s\n", SDL_GetError());
+			exit(EXIT_FAILURE);
+		}
+	}
 
-					}
+	return pool;
+}
 
-				} break;
+void destroyJobPool(jobPool_t *pool)
+{
+	// wake every worker, they exit instead of looking for jobs
+	SDL_AtomicSet(&pool->quit, 1);
+	for(int i = 0; i < pool->numWorkers; i++) {
+		SDL_SemPost(pool->available);
+	}
+	for(int i = 0; i < pool->numWorkers; i++) {
+		SDL_WaitThread(pool->workers[i].thread, NULL);
+	}
+	SDL_DestroySemaphore(pool->available);
+	SDL_DestroyCond(pool->waitCond);
+	SDL_DestroyMutex(pool->waitLock);
+	freeMemory(MEMORY_JOBS, pool);
+}
 
-				// close the game if the player presses enter in the final window
-				case GAME_STATE_ENDED: {
-					if(PRESSED_KEY == SDLK_RETURN) {
-						game.state = GAME_STATE_CLOSE;
-					}
-				} break;
+void initJob(job_t *job,
+			 void (*run)(void *data),
+			 void (*complete)(void *data),
+			 void *data)
+{
+	memset(job, 0, sizeof(job_t));
+	job->run = run;
+	job->complete = complete;
+	job->data = data;
+	SDL_AtomicSet(&job->unfinished, 1);
+}
 
-				case GAME_STATE_CLOSE: {
-				} break;
+void addJobDependency(jobPool_t *pool, job_t *job, job_t *dependency)
+{
+	// must be called before submitting the job
+	SDL_AtomicLock(&dependency->lock);
+	bool wait = false;
+	if(!dependency->finished) {
+		if(dependency->numDependents < JOB_MAX_DEPENDENTS) {
+			dependency->dependents[dependency->numDependents++] = job;
+			SDL_AtomicAdd(&job->unfinished, 1);
+		} else {
+			wait = true;
+		}
+	}
+	SDL_AtomicUnlock(&dependency->lock);
 
-				default: {
-				} break;
+	// too many dependents, wait for the dependency instead
+	if(wait) {
+		waitJob(pool, dependency);
+	}
+}
 
-				}
-			} break;
+void submitJob(jobPool_t *pool, job_t *job)
+{
+	// queue the job once all its dependencies are done
+	if(SDL_AtomicAdd(&job->unfinished, -1) != 1) {
+		return;
+	}
 
-			default: {
-			} break;
+	int id = (Uint32) SDL_AtomicAdd(&pool->nextQueue, 1) % pool->numWorkers;
+	if(pushJob(&pool->queues[id], job)) {
+		SDL_SemPost(pool->available);
+		wakeWaiters(pool);
+	} else {
+		// the queue is full, run it now
+		runJob(pool, job);
+	}
+}
 
-			}
+void waitJob(jobPool_t *pool, job_t *job)
+{
+	// help the workers while waiting, so waiting from a job can't deadlock
+	while(!SDL_AtomicGet(&job->done)) {
+		if(SDL_SemTryWait(pool->available) == 0) {
+			runJob(pool, takeJob(pool, -1));
+			continue;
 		}
 
-		// clear renderer queue
-		SDL_RenderClear(renderer);
+		// nothing to help with, sleep until a job is queued or done
+		SDL_AtomicAdd(&pool->waiters, 1);
+		SDL_LockMutex(pool->waitLock);
+		while(!SDL_AtomicGet(&job->done) && SDL_SemValue(pool->available) == 0) {
+			SDL_CondWait(pool->waitCond, pool->waitLock);
+		}
+		SDL_UnlockMutex(pool->waitLock);
+		SDL_AtomicAdd(&pool->waiters, -1);
+	}
+}
 
-		// render all game parts in base of the game state
-		renderGame(renderer, &game);
+void wakeWaiters(jobPool_t *pool)
+{
+	// the waiters check under the lock, so the wake up can't happen between their check and their sleep
+	if(SDL_AtomicGet(&pool->waiters) > 0) {
+		SDL_LockMutex(pool->waitLock);
+		SDL_CondBroadcast(pool->waitCond);
+		SDL_UnlockMutex(pool->waitLock);
+	}
+}
 
-		// call to render the frame
-		SDL_RenderPresent(renderer);
+bool pushJob(jobQueue_t *queue, job_t *job)
+{
+	SDL_AtomicLock(&queue->lock);
+	bool pushed = queue->bottom - queue->top < JOBS_QUEUE_SIZE;
+	if(pushed) {
+		queue->jobs[queue->bottom++ % JOBS_QUEUE_SIZE] = job;
+	}
+	SDL_AtomicUnlock(&queue->lock);
+	return pushed;
+}
+
+job_t *takeJob(jobPool_t *pool, int id)
+{
+	// a job is queued for every semaphore count taken, keep looking until found
+	while(true) {
+		// the newest job of the own queue is still in cache
+		if(id >= 0) {
+			jobQueue_t *queue = &pool->queues[id];
+			SDL_AtomicLock(&queue->lock);
+			job_t *job = NULL;
+			if(queue->bottom > queue->top) {
+				job = queue->jobs[--queue->bottom % JOBS_QUEUE_SIZE];
+				if(queue->top == queue->bottom) {
+					queue->top = queue->bottom = 0;
+				}
+			}
+			SDL_AtomicUnlock(&queue->lock);
+			if(job != NULL) {
+				return job;
+			}
+		}
 
+		// steal the oldest job of another worker
+		for(int i = 1; i <= pool->numWorkers; i++) {
+			jobQueue_t *queue = &pool->queues[(id + i + pool->numWorkers) % pool->numWorkers];
+			SDL_AtomicLock(&queue->lock);
+			job_t *job = NULL;
+			if(queue->bottom > queue->top) {
+				job = queue->jobs[queue->top++ % JOBS_QUEUE_SIZE];
+				// restart from the beginning when empty, the counters never overflow
+				if(queue->top == queue->bottom) {
+					queue->top = queue->bottom = 0;
+				}
+			}
+			SDL_AtomicUnlock(&queue->lock);
+			if(job != NULL) {
+				return job;
+			}
+		}
 	}
+}
 
+void runJob(jobPool_t *pool, job_t *job)
+{
+	job->run(job->data);
+
+	// collect the jobs waiting for it, no other one can be added
+	bool complete = job->complete != NULL;
+	job_t *dependents[JOB_MAX_DEPENDENTS];
+	SDL_AtomicLock(&job->lock);
+	job->finished = true;
+	size_t numDependents = job->numDependents;
+	memcpy(dependents, job->dependents, sizeof(job_t *) * numDependents);
+	SDL_AtomicUnlock(&job->lock);
+
+	// once it's done the waiting thread can free the job, so it's the last access to it
+	SDL_AtomicSet(&job->done, 1);
+	wakeWaiters(pool);
+
+	for(size_t i = 0; i < numDependents; i++) {
+		submitJob(pool, dependents[i]);
+	}
 
-	// free window resources
-	SDL_DestroyWindow(window);
+	// the game thread gets the completion with the other events, the jobs with one are kept until then
+	if(complete) {
+		SDL_Event event = {0};
+		event.type = pool->eventType;
+		event.user.data1 = job;
+		SDL_PushEvent(&event);
+	}
+}
 
-	// free renderer resources
-	SDL_DestroyRenderer(renderer);
+int jobWorker(void *data)
+{
+	jobWorker_t *worker = data;
+	jobPool_t *pool = worker->pool;
 
-	// free audio resources
-	freeAudio(game.assets.sounds);
+	while(true) {
+		SDL_SemWait(pool->available);
+		if(SDL_AtomicGet(&pool->quit)) {
+			break;
+		}
+		runJob(pool, takeJob(pool, worker->id));
+	}
 
-	// closing and cleaning TTF, Mixer and SDL libraries 
-	TTF_Quit();
-	Mix_CloseAudio();
-	SDL_Quit();
+	return 0;
+}
 
-	return EXIT_SUCCESS;
+void completeJob(const SDL_Event *event)
+{
+	job_t *job = event->user.data1;
+	job->complete(job->data);
 }
 
+int textWidth(const assets_t *assets, fonts_t font, const char *text)
+{
+	int width = 0;
+	if(assets->useAtlas) {
+		// sum of the advances of the glyphs
+		while(*text != '\0') {
+			width += assets->atlas.glyphs[font][assets->atlas.glyphOf[nextLatin1(&text)]].advance;
+		}
+	} else {
+		TTF_SizeUTF8(assets->fonts[font], text, &width, NULL);
+	}
+	return width;
+}
 
-char randomVocal(void)
+bool canTypeLetter(const game_t *game, char letter)
 {
-	return vocals[rand()%5];
+	if(game->multiset) {
+		// every blank gives one more copy of any letter
+		char word[MAX_WORD_SIZE+1];
+		snprintf(word, sizeof(word), "%s%c", game->currentWord, letter);
+		return excessLetters(letterCounts(word), game->rackCounts) <= (Uint32) game->blanks;
+	}
+
+	// every blank gives one letter not in the rack, which can be used again like the others
+	Uint32 missing = (letterMask(game->currentWord) | (1u << (letter - 'A'))) & ~game->rackMask;
+	return countLetters(missing) <= game->blanks;
 }
 
-char randomConsonant(void)
+void buildWorkingSet(game_t *game)
 {
-	return consonants[rand()%strlen(consonants)];
+	Uint64 start = SDL_GetPerformanceCounter();
+	const assets_t *assets = &game->assets;
+	workingSet_t *set = &game->workingSet;
+	Uint32 notRack = ~game->rackMask;
+
+	// count, then copy the ids without branches
+	// a word is playable if the letters missing from the rack are no more than the blanks,
+	// removing the lowest missing letter once for every blank
+	const Uint32 *masks = assets->wordMasks;
+	int blanks = game->blanks;
+	Uint32 num = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		Uint32 missing = masks[i] & notRack & ~LETTER_INVALID_BIT;
+		for(int b = 0; b < MAX_BLANKS; b++) {
+			missing &= b < blanks ? missing - 1 : ~0u;
+		}
+		num += (missing | (masks[i] & LETTER_INVALID_BIT)) == 0;
+	}
+	freeMemory(MEMORY_WORKING_SET, set->ids);
+	// the copy always writes one id past the last word of the set
+	set->ids = allocMemory(MEMORY_WORKING_SET, sizeof(Uint32) * (num+1));
+	if(set->ids == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the words of the rack\n");
+		exit(EXIT_FAILURE);
+	}
+	size_t k = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		Uint32 missing = masks[i] & notRack & ~LETTER_INVALID_BIT;
+		for(int b = 0; b < MAX_BLANKS; b++) {
+			missing &= b < blanks ? missing - 1 : ~0u;
+		}
+		set->ids[k] = i;
+		k += (missing | (masks[i] & LETTER_INVALID_BIT)) == 0;
+	}
+	// with the letters used once the words also need enough copies of every letter,
+	// they are among the ones above so only those are checked
+	if(game->multiset) {
+		k = 0;
+		for(size_t i = 0; i < num; i++) {
+			set->ids[k] = set->ids[i];
+			k += excessLetters(assets->wordCounts[set->ids[i]], game->rackCounts) <= (Uint32) blanks;
+		}
+		num = k;
+	}
+	set->num = num;
+
+	// at most half full, so the probe sequences stay short
+	set->tableSize = 16;
+	while(set->tableSize < 2*num) {
+		set->tableSize *= 2;
+	}
+	freeMemory(MEMORY_WORKING_SET, set->table);
+	set->table = allocMemory(MEMORY_WORKING_SET, sizeof(Uint32) * set->tableSize);
+	if(set->table == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the words of the rack\n");
+		exit(EXIT_FAILURE);
+	}
+	for(size_t i = 0; i < num; i++) {
+		const char *word = assets->words[set->ids[i]];
+		size_t slot = hashWord(word) & (set->tableSize-1);
+		while(set->table[slot] != 0) {
+			// the same word may be in both lists, the first one is kept
+			if(strcmp(assets->words[set->ids[set->table[slot]-1]], word) == 0) {
+				break;
+			}
+			slot = (slot+1) & (set->tableSize-1);
+		}
+		if(set->table[slot] == 0) {
+			set->table[slot] = i+1;
+		}
+	}
+
+	observeLatency(LATENCY_WORKING_SET, start);
 }
 
-int getFontWidth(TTF_Font *font, const char *text)
+Sint32 findRackWord(const game_t *game, const char *word)
 {
-	int width;
-	TTF_SizeText(font, text, &width, NULL);
-	return width;
+	// dictionary id of the word, -1 if it isn't in the working set
+	const workingSet_t *set = &game->workingSet;
+	if(set->table == NULL) {
+		return -1;
+	}
+	size_t slot = hashWord(word) & (set->tableSize-1);
+	while(set->table[slot] != 0) {
+		Uint32 id = set->ids[set->table[slot]-1];
+		if(strcmp(game->assets.words[id], word) == 0) {
+			return id;
+		}
+		slot = (slot+1) & (set->tableSize-1);
+	}
+	return -1;
 }
 
 void checkWordAndPlay(game_t *game)
 {
+	Uint64 start = SDL_GetPerformanceCounter();
+
 	// check the word is at least 2 characters long
 	if(strlen(game->currentWord) > 1) {
+		countMetric(COUNTER_VALIDATIONS);
+
 		char word[MAX_WORD_SIZE];
 		// copy the word in a local backup
 		strcpy(word, game->currentWord);
 
-		// reset the word
+		// reset the word and the old suggestions
 		memset(game->currentWord, 0, MAX_WORD_SIZE);
 		game->currentWordSize = 0;
+		game->suggestionsNum = 0;
 
-		// check that the word is a valid word
-		bool valid = false;
-		for(size_t i = 0; i < game->assets.numWords; i++) {
-			if(strcmp(word, game->assets.words[i]) == 0) {
-				valid = true;
-				break;
-			}
-		}
+		// check that the word is a valid word, only the words of the rack can be typed
+		Sint32 id = findRackWord(game, word);
 
-		if(valid) {
+		if(id >= 0) {
 			// if it is valid check that it hasn't been already used
 			bool used = false;
 			for(size_t i = 0; i < game->guessedWordsNum; i++) {
-				if(strcmp(word, game->guessedWords[i]) == 0) {
+				if(game->guessedIds[i] == (Uint32) id) {
 					used = true;
 					break;
 				}
 			}
 
-			// if it isn't used
-			if(!used) {
+			// if it isn't used, and there is space for it
+			if(!used && game->guessedWordsNum < MAX_GUESSED_WORDS) {
 				// play the correct sound
 				playSound(game->assets.sounds[AUDIO_CORRECT]);
 
 				// add the word to the used words list
 				strcpy(game->guessedWords[game->guessedWordsNum], word);
+				game->guessedIds[game->guessedWordsNum] = id;
+				game->guessedAt[game->guessedWordsNum] = TIME_MAX - game->timeLeft;
 				game->guessedWordsNum++;
 
 				// calculate the points of the word based on the length
-				switch(strlen(word)) {
-
-				case 2:
-				case 3:
-				case 4: {
-					game->points += 1;
-				} break;
-
-				case 5: {
-					game->points += 2;
-				} break;
-
-				case 6: {
-					game->points += 3;
-				} break;
-
-				case 7: {
-					game->points += 5;
-				} break;
-
-				default: {
-					game->points += 11;
-				} break;
-
-				}
+				game->points += wordPoints(POINTS_BY_LENGTH, NUM_POINTS_BY_LENGTH, strlen(word));
 
 				// set last word state
 				game->lastWordT = LAST_WORD_VALID;
+				countMetric(COUNTER_ACCEPTED);
 			} else {
 				playSound(game->assets.sounds[AUDIO_INCORRECT]);
 				game->lastWordT = LAST_WORD_INVALID;
+				countMetric(COUNTER_REJECTED);
 			}
 		} else {
 			playSound(game->assets.sounds[AUDIO_INCORRECT]);
 			game->lastWordT = LAST_WORD_INVALID;
+			countMetric(COUNTER_REJECTED);
+			// look for the words the player could have meant
+			findSuggestions(game, word);
 		}
+
+		observeLatency(LATENCY_CHECK_WORD, start);
 	}
 }
 
-void findValidWord(const game_t *game, char *word)
+int editDistance(const char *a, const char *b, int max)
 {
-	size_t lenM = 0;
+	size_t lenA = strlen(a), lenB = strlen(b);
+	int rows[2][MAX_WORD_SIZE+1];
 
-	// scan all the valid words
-	for(size_t i = 0; i < game->assets.numWords; i++) {
-		bool valid = true;
-
-		// if the length of the current word is longer
-		size_t len = strlen(game->assets.words[i]);
-		if(len > lenM) {
-			// check that all the characters of the word are valid
-			for(size_t j = 0; j < len; j++) {
-				bool charFound = false;
-				for(size_t k = 0; k < NUM_AVAILABLE_CHARS; k++) {
-					if(game->assets.words[i][j] == game->validCharList[k]) {
-						charFound = true;
-						break;
-					}
-				}
+	for(size_t j = 0; j <= lenB; j++) {
+		rows[0][j] = j;
+	}
 
-				if(!charFound) {
-					valid = false;
-					break;
-				}
+	// levenshtein distance, keeping only the previous row
+	for(size_t i = 1; i <= lenA; i++) {
+		int *prev = rows[(i-1)%2], *row = rows[i%2];
+		int rowMin = row[0] = i;
+		for(size_t j = 1; j <= lenB; j++) {
+			int cost = prev[j-1] + (a[i-1] != b[j-1]);
+			if(prev[j] + 1 < cost) {
+				cost = prev[j] + 1;
 			}
-
-			// if the word is still valid, set it as the longest word
-			if(valid) {
-				lenM = len;
-				strcpy(word, game->assets.words[i]);
+			if(row[j-1] + 1 < cost) {
+				cost = row[j-1] + 1;
 			}
+			row[j] = cost;
+			if(cost < rowMin) {
+				rowMin = cost;
+			}
+		}
+		// the distance can't decrease anymore
+		if(rowMin > max) {
+			return max+1;
 		}
 	}
+
+	return rows[lenA%2][lenB];
 }
 
-void loadFont(assets_t * const assets,
-			  fonts_t fontId,
-			  const char *name,
-			  size_t size)
+void findSuggestions(game_t *game, const char *word)
 {
-	// creating path
-	char path[100] = "./assets/fonts/";
-	strcat(path, name);
-	fprintf(stdout, "Loading font: %s ...\n",path);
-	// loading font
-	TTF_Font *font = TTF_OpenFont(path, size);
-	if(font == NULL) {
-		fprintf(stderr, "Error: %s", TTF_GetError());
-		exit(EXIT_FAILURE);
+	Uint64 start = SDL_GetPerformanceCounter();
+	const assets_t *assets = &game->assets;
+	size_t len = strlen(word);
+	int distances[MAX_SUGGESTIONS];
+	game->suggestionsNum = 0;
+
+	// only words within the maximum distance in length can be close enough
+	size_t minLen = len > MAX_SUGGESTION_DISTANCE ? len - MAX_SUGGESTION_DISTANCE : 2;
+	size_t maxLen = len + MAX_SUGGESTION_DISTANCE;
+	if(minLen < 2) {
+		minLen = 2;
 	}
-	fprintf(stdout, "Font loaded.\n");
-	assets->fonts[fontId] = font;
-	assets->fontSizes[fontId] = size;
+	if(maxLen > MAX_WORD_SIZE-1) {
+		maxLen = MAX_WORD_SIZE-1;
+	}
+
+	// the suggestion must be playable with the rack
+	const workingSet_t *set = &game->workingSet;
+	for(size_t k = 0; k < set->num; k++) {
+		Uint32 id = set->ids[k];
+		size_t wordLen = strlen(assets->words[id]);
+		if(wordLen < minLen || wordLen > maxLen) {
+			continue;
+		}
+
+		// the worst suggestion is replaced only by a closer one
+		int max = MAX_SUGGESTION_DISTANCE;
+		if(game->suggestionsNum == MAX_SUGGESTIONS) {
+			max = distances[MAX_SUGGESTIONS-1] - 1;
+		}
+		int distance = editDistance(word, assets->words[id], max);
+		if(distance > max) {
+			continue;
+		}
+
+		// skip the words already guessed, or already suggested from the other list
+		bool skip = findRackWord(game, assets->words[id]) != (Sint32) id;
+		for(size_t i = 0; i < game->guessedWordsNum && !skip; i++) {
+			skip = game->guessedIds[i] == id;
+		}
+		if(skip) {
+			continue;
+		}
+
+		// insert the word keeping the suggestions sorted by distance
+		size_t pos = game->suggestionsNum < MAX_SUGGESTIONS ? game->suggestionsNum++ : MAX_SUGGESTIONS-1;
+		while(pos > 0 && distances[pos-1] > distance) {
+			distances[pos] = distances[pos-1];
+			strcpy(game->suggestions[pos], game->suggestions[pos-1]);
+			pos--;
+		}
+		distances[pos] = distance;
+		// as it is written, so showing it doesn't need the dictionary
+		strcpy(game->suggestions[pos], wordText(assets, id));
+	}
+
+	observeLatency(LATENCY_SUGGESTIONS, start);
 }
 
-void loadAudio(assets_t * const assets,
-			  audios_t audioId,
-			  const char *name)
+void findValidWord(const game_t *game, char *word)
 {
-	// creating path
-	char path[100] = "./assets/sounds/";
-	strcat(path, name);
-	fprintf(stdout, "Loading sound: %s ...\n",path);
-	// loading audio
-	Mix_Chunk *sound = Mix_LoadWAV(path);
-	if(sound == NULL)
-	{
-		fprintf(stderr, "Error: %s", Mix_GetError());
-		exit(EXIT_FAILURE);
+	Uint64 start = SDL_GetPerformanceCounter();
+	const workingSet_t *set = &game->workingSet;
+	size_t lenM = 0;
+	word[0] = '\0';
+
+	// all the words of the working set are valid, keep the first of the longest ones
+	for(size_t k = 0; k < set->num; k++) {
+		size_t len = strlen(game->assets.words[set->ids[k]]);
+		if(len > lenM) {
+			lenM = len;
+			strcpy(word, wordText(&game->assets, set->ids[k]));
+		}
 	}
-	assets->sounds[audioId] = sound;
-	fprintf(stdout, "Sound loaded.\n");
+
+	observeLatency(LATENCY_SOLVER, start);
 }
 
-void loadText(assets_t * const assets, const char *name)
+void longestWordJob(void *data)
 {
-	size_t num = assets->numWords;
-	// creating path
-	char path[100] = "./assets/texts/";
-	strcat(path, name);
-	fprintf(stdout, "Loading texts: %s ...\n",path);
-	// opening file
-	FILE *fp = fopen(path, "r");
-	if(fp == NULL) {
-		fprintf(stderr, "Error: couldn't load file: %s", path);
-		exit(EXIT_FAILURE);
-	}
-	// loading word until the end of file, or until max num of words reached
-	char word[MAX_WORD_SIZE];
-	while(assets->numWords < MAX_WORDS && fgets(word, MAX_WORD_SIZE-1, fp)) {
-		// removing any line terminator
-		char *ptr = strchr(word, '\r');
-		if(ptr != NULL) {
-			*ptr = '\0';
+	game_t *game = data;
+	findValidWord(game, game->longestWord);
+}
+
+void longestWordCompleted(void *data)
+{
+	game_t *game = data;
+	game->longestWordReady = true;
+}
+
+int parseGameOptions(game_t *game, int argc, char *argv[])
+{
+	for(int i = 0; i < argc; i++) {
+		if(strcmp(argv[i], "--opponent") == 0 && i+1 < argc) {
+			// play against the computer, with the given skill
+			game->opponent.enabled = true;
+			game->opponent.skill = atoi(argv[++i]);
+			if(game->opponent.skill < 1 || game->opponent.skill > 100) {
+				fprintf(stderr, "Error: the opponent skill must be between 1 and 100\n");
+				return -1;
+			}
+		} else if(strcmp(argv[i], "--metrics") == 0 && i+1 < argc) {
+			// file where the metrics are exported
+			game->metricsPath = argv[++i];
+		} else if(strcmp(argv[i], "--multiset") == 0) {
+			game->multiset = true;
+		} else if(strcmp(argv[i], "--jolly") == 0 && i+1 < argc) {
+			// blanks the player can put in the rack
+			game->maxBlanks = atoi(argv[++i]);
+			if(game->maxBlanks < 0 || game->maxBlanks > MAX_BLANKS) {
+				fprintf(stderr, "Error: the blanks must be between 0 and %d\n", MAX_BLANKS);
+				return -1;
+			}
+		} else if(strcmp(argv[i], "--memory-budget") == 0 && i+1 < argc) {
+			// warn when a subsystem uses more memory
+			if(parseMemoryBudget(argv[++i]) != 0) {
+				fprintf(stderr, "Error: the memory budget must be NAME=MB, the names are resident");
+				for(size_t j = 0; j < NUM_MEMORY_USES; j++) {
+					fprintf(stderr, ", %s", MEMORY_NAMES[j]);
+				}
+				fprintf(stderr, "\n");
+				return -1;
+			}
+		} else if(strcmp(argv[i], "--broadcast") == 0) {
+			// publish the round for the spectators
+			game->feed = openFeed();
+			if(game->feed == NULL) {
+				return -1;
+			}
+		} else {
+			fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+			return -1;
 		}
-		ptr = strchr(word, '\n');
-		if(ptr != NULL) {
-			*ptr = '\0';
+	}
+
+	return 0;
+}
+
+void countMetric(counters_t counter)
+{
+	SDL_AtomicAdd(&metrics.counters[counter], 1);
+}
+
+int latencyBucket(Uint64 us)
+{
+	// small values have a bucket each
+	if(us < LATENCY_SUB_BUCKETS) {
+		return us;
+	}
+	if(us > 0xffffffffu) {
+		us = 0xffffffffu;
+	}
+
+	// the position of the highest bit selects the range, the next bits the bucket in it
+	int exponent = 0;
+	while((us >> exponent) >= 2*LATENCY_SUB_BUCKETS) {
+		exponent++;
+	}
+	return (exponent+1) * LATENCY_SUB_BUCKETS + (int)(us >> exponent) - LATENCY_SUB_BUCKETS;
+}
+
+Uint64 latencyBucketValue(int bucket)
+{
+	if(bucket < LATENCY_SUB_BUCKETS) {
+		return bucket;
+	}
+
+	// middle of the values that fall in the bucket
+	int exponent = bucket / LATENCY_SUB_BUCKETS - 1;
+	Uint64 low = (Uint64)(bucket % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS) << exponent;
+	return low + ((1ull << exponent) >> 1);
+}
+
+void observeLatency(latencies_t latency, Uint64 start)
+{
+	Uint64 us = (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+	SDL_AtomicAdd(&metrics.latencies[latency][latencyBucket(us)], 1);
+}
+
+void exportMetrics(const char *path)
+{
+	// write a new file and replace the old one, the scraper never reads a partial file
+	char tmpPath[FILENAME_MAX];
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+	FILE *fp = fopen(tmpPath, "w");
+	if(fp == NULL) {
+		fprintf(stderr, "Error: couldn't write metrics to %s\n", tmpPath);
+		return;
+	}
+
+	for(size_t i = 0; i < NUM_COUNTERS; i++) {
+		fprintf(fp, "# HELP %s %s\n", COUNTER_NAMES[i][0], COUNTER_NAMES[i][1]);
+		fprintf(fp, "# TYPE %s counter\n", COUNTER_NAMES[i][0]);
+		fprintf(fp, "%s %d\n", COUNTER_NAMES[i][0], SDL_AtomicGet(&metrics.counters[i]));
+	}
+
+	// latencies are exported as summaries, with the quantiles taken from the buckets
+	const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+	size_t numQuantiles = sizeof(quantiles)/sizeof(double);
+	for(size_t i = 0; i < NUM_LATENCIES; i++) {
+		int buckets[NUM_LATENCY_BUCKETS];
+		Uint64 count = 0;
+		double sum = 0;
+		for(int j = 0; j < NUM_LATENCY_BUCKETS; j++) {
+			buckets[j] = SDL_AtomicGet(&metrics.latencies[i][j]);
+			count += buckets[j];
+			sum += (double) buckets[j] * latencyBucketValue(j) / 1e6;
+		}
+
+		fprintf(fp, "# HELP %s %s\n", LATENCY_NAMES[i][0], LATENCY_NAMES[i][1]);
+		fprintf(fp, "# TYPE %s summary\n", LATENCY_NAMES[i][0]);
+		Uint64 seen = 0;
+		int bucket = 0;
+		for(size_t q = 0; q < numQuantiles && count > 0; q++) {
+			while(bucket < NUM_LATENCY_BUCKETS-1 && seen + buckets[bucket] < quantiles[q] * count) {
+				seen += buckets[bucket++];
+			}
+			fprintf(fp, "%s{quantile=\"%g\"} %g\n", LATENCY_NAMES[i][0], quantiles[q],
+					latencyBucketValue(bucket) / 1e6);
 		}
-		strcpy(assets->words[assets->numWords++], word);
+		fprintf(fp, "%s_sum %g\n", LATENCY_NAMES[i][0], sum);
+		fprintf(fp, "%s_count %llu\n", LATENCY_NAMES[i][0], (unsigned long long) count);
+	}
+
+	fprintf(fp, "# HELP paroliere_memory_bytes Memory used by every subsystem.\n");
+	fprintf(fp, "# TYPE paroliere_memory_bytes gauge\n");
+	Sint64 current[NUM_MEMORY_USES], peak[NUM_MEMORY_USES];
+	readMemory(current, peak);
+	for(size_t i = 0; i < NUM_MEMORY_USES; i++) {
+		fprintf(fp, "paroliere_memory_bytes{subsystem=\"%s\"} %lld\n", MEMORY_NAMES[i],
+				(long long) current[i]);
+	}
+	fprintf(fp, "# HELP paroliere_resident_bytes Resident memory of the process.\n");
+	fprintf(fp, "# TYPE paroliere_resident_bytes gauge\n");
+	fprintf(fp, "paroliere_resident_bytes %lld\n", (long long) residentMemory());
+
+	bool ok = fclose(fp) == 0;
+	if(!ok || rename(tmpPath, path) != 0) {
+		fprintf(stderr, "Error: couldn't write metrics to %s\n", path);
 	}
-	fprintf(stdout, "Loaded %zu words.\n", assets->numWords - num);
 }
 
-void loadAssets(assets_t * const assets)
+void trackMemory(memoryUses_t use, Sint64 bytes)
 {
-	// loading all assets
+	// SDL has no 64 bit atomic add, the lock is held only for a few additions
+	SDL_AtomicLock(&memory.lock);
+	Sint64 current = memory.current[use] += bytes;
+	if(current > memory.peak[use]) {
+		memory.peak[use] = current;
+	}
 
-	loadFont(assets, FONT_ROBOTO_LIGHT, "Roboto-Light.ttf", 35);
-	loadFont(assets, FONT_ROBOTO_REGULAR, "Roboto-Regular.ttf", 50);
-	loadFont(assets, FONT_ROBOTO_BOLD, "Roboto-Bold.ttf", 70);
-	loadFont(assets, FONT_SEVEN_SEGMENTS, "Seven-Segment.ttf", 100);
+	// warn when the budget is exceeded, and again if it happens after going back under it
+	Sint64 budget = memory.budgets[use];
+	bool warn = false;
+	if(budget > 0 && current > budget && !memory.overBudget[use]) {
+		memory.overBudget[use] = true;
+		warn = true;
+	} else if(budget > 0 && current <= budget) {
+		memory.overBudget[use] = false;
+	}
+	SDL_AtomicUnlock(&memory.lock);
 
-	loadAudio(assets, AUDIO_TIC, "tic.wav");
-	loadAudio(assets, AUDIO_TAC, "tac.wav");
-	loadAudio(assets, AUDIO_CORRECT, "correct.wav");
-	loadAudio(assets, AUDIO_INCORRECT, "incorrect.wav");
+	if(warn) {
+		fprintf(stderr, "WARNING: the %s memory is %.2f MB, over its budget of %.2f MB\n",
+				MEMORY_NAMES[use], current / 1048576.0, budget / 1048576.0);
+	}
+}
 
-	loadText(assets, "words.txt");
-	loadText(assets, "words2.txt");
+void readMemory(Sint64 current[NUM_MEMORY_USES], Sint64 peak[NUM_MEMORY_USES])
+{
+	// a consistent copy, the counters can be written by the workers meanwhile
+	SDL_AtomicLock(&memory.lock);
+	memcpy(current, memory.current, sizeof(memory.current));
+	memcpy(peak, memory.peak, sizeof(memory.peak));
+	SDL_AtomicUnlock(&memory.lock);
 }
 
-void freeAudio(Mix_Chunk *sounds[NUM_AUDIO]) {
-	for(size_t i = 0; i < NUM_AUDIO; i++) {
-		Mix_FreeChunk(sounds[i]);
+void *allocMemory(memoryUses_t use, size_t size)
+{
+	// zeroed, like calloc
+	memoryHeader_t *header = calloc(1, sizeof(memoryHeader_t) + size);
+	if(header == NULL) {
+		return NULL;
 	}
+	header->size = size;
+	trackMemory(use, size);
+	return header + 1;
 }
 
-void playSound(Mix_Chunk *sound) {
-	// play sound in the default channel
-	Mix_PlayChannel(-1, sound, 0);
+void *reallocMemory(memoryUses_t use, void *pointer, size_t size)
+{
+	if(pointer == NULL) {
+		return allocMemory(use, size);
+	}
+	memoryHeader_t *header = (memoryHeader_t *) pointer - 1;
+	size_t old = header->size;
+	header = realloc(header, sizeof(memoryHeader_t) + size);
+	if(header == NULL) {
+		return NULL;
+	}
+	header->size = size;
+	trackMemory(use, (Sint64) size - (Sint64) old);
+	return header + 1;
 }
 
-void renderRect(SDL_Renderer *renderer,
-				SDL_Color color,
-				int x, int y,
-				int width, int height)
+void freeMemory(memoryUses_t use, void *pointer)
 {
-	// set color
-	COLOR_SET(renderer, color);
-	// declare rectangle
-	SDL_Rect b = {x, y, width, height};
-	// render rectangle
-	SDL_RenderFillRect(renderer, &b);
+	if(pointer == NULL) {
+		return;
+	}
+	memoryHeader_t *header = (memoryHeader_t *) pointer - 1;
+	trackMemory(use, -(Sint64) header->size);
+	free(header);
 }
 
+Sint64 residentMemory(void)
+{
+	// the second number is the resident pages
+	long pages = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+	if(fp != NULL) {
+		if(fscanf(fp, "%*d %ld", &pages) != 1) {
+			pages = 0;
+		}
+		fclose(fp);
+	}
+	return (Sint64) pages * sysconf(_SC_PAGESIZE);
+}
 
-void renderText(SDL_Renderer *renderer,
-				const game_t *game, 
-				SDL_Color color,
-				const char *text,
-				TTF_Font *font,
-				alignment_t alignment,
-				int x, int y)
+Sint64 peakResidentMemory(void)
 {
-	// create text surface
-	SDL_Surface* messageSurface = TTF_RenderText_Solid(font, text, color);
+	// kilobytes on linux
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return (Sint64) usage.ru_maxrss * 1024;
+}
 
-	// create texture from surface
-	SDL_Texture* messageTexture = SDL_CreateTextureFromSurface(renderer, messageSurface);
+void reportMemory(const char *when)
+{
+	Sint64 resident = residentMemory();
+	fprintf(stdout, "Memory %s: resident %.2f MB, peak %.2f MB\n",
+			when, resident / 1048576.0, peakResidentMemory() / 1048576.0);
+	Sint64 current[NUM_MEMORY_USES], peak[NUM_MEMORY_USES];
+	readMemory(current, peak);
+	for(size_t i = 0; i < NUM_MEMORY_USES; i++) {
+		fprintf(stdout, "  %-12s %8.2f MB, peak %8.2f MB\n", MEMORY_NAMES[i],
+				current[i] / 1048576.0, peak[i] / 1048576.0);
+	}
 
-	int textWidth;
-	TTF_SizeText(font, text, &textWidth, NULL);
+	if(memory.residentBudget > 0 && resident > memory.residentBudget) {
+		fprintf(stderr, "WARNING: the resident memory is %.2f MB, over its budget of %.2f MB\n",
+				resident / 1048576.0, memory.residentBudget / 1048576.0);
+	}
+}
 
-	// calculating x based on the alignment
-	switch(alignment) {
+int parseMemoryBudget(const char *budget)
+{
+	// NAME=MB, where the name is a subsystem or "resident"
+	const char *equal = strchr(budget, '=');
+	if(equal == NULL || atof(equal+1) <= 0) {
+		return -1;
+	}
+	Sint64 bytes = atof(equal+1) * 1048576;
+	size_t len = equal - budget;
+	if(len == strlen("resident") && strncmp(budget, "resident", len) == 0) {
+		memory.residentBudget = bytes;
+		return 0;
+	}
+	for(size_t i = 0; i < NUM_MEMORY_USES; i++) {
+		if(len == strlen(MEMORY_NAMES[i]) && strncmp(budget, MEMORY_NAMES[i], len) == 0) {
+			memory.budgets[i] = bytes;
+			return 0;
+		}
+	}
+	return -1;
+}
 
-	case TEXT_ALIGNMENT_LEFT: {
-		x = 4*BORDER_THICKNESS;
-	} break;
+void startOpponent(game_t *game)
+{
+	opponent_t *opponent = &game->opponent;
+	if(!opponent->enabled) {
+		return;
+	}
+	opponent->rng = rand() | 1;
+	restartOpponentSearch(opponent);
+	// the better the opponent, the sooner it writes the first word
+	opponent->nextWordTicks = SDL_GetTicks() + OPPONENT_WORD_TIME_MS * 100 / opponent->skill;
+}
 
-	case TEXT_ALIGNMENT_CENTER: {
-		x = (game->screen_width-textWidth)/2;
-	} break;
+void restartOpponentSearch(opponent_t *opponent)
+{
+	// from the start of the working set, the found words may not be in it anymore
+	opponent->cursor = 0;
+	opponent->numFound = 0;
+	opponent->numCandidates = 0;
+}
 
-	case TEXT_ALIGNMENT_RIGHT: {
-		x = game->screen_width-textWidth-4*BORDER_THICKNESS;
-	} break;
+void stepOpponent(game_t *game)
+{
+	opponent_t *opponent = &game->opponent;
+	if(!opponent->enabled) {
+		return;
+	}
 
-	// x remains the same for custom alignment
-	case TEXT_ALIGNMENT_CUSTOM: {
-	} break;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 deadline = start + frequency * OPPONENT_FRAME_BUDGET_US / 1000000;
 
-	default: {
-	} break;
+	// resume the search where the last frame stopped, until the budget is over
+	const workingSet_t *set = &game->workingSet;
+	while(opponent->cursor < set->num) {
+		size_t i = set->ids[opponent->cursor++];
+
+		if(strlen(game->assets.words[i]) > 1 &&
+		   (int)(nextRandom(&opponent->rng)%100) < opponent->skill) {
+			// keep a random sample of the found words, so they aren't written alphabetically
+			if(opponent->numFound < OPPONENT_MAX_FOUND) {
+				opponent->found[opponent->numFound++] = i;
+			} else {
+				size_t j = nextRandom(&opponent->rng) % (opponent->numCandidates+1);
+				if(j < OPPONENT_MAX_FOUND) {
+					opponent->found[j] = i;
+				}
+			}
+			opponent->numCandidates++;
+		}
 
+		// reading the clock is slower than checking a word
+		if(opponent->cursor % OPPONENT_CHECK_INTERVAL == 0 &&
+		   SDL_GetPerformanceCounter() >= deadline) {
+			break;
+		}
 	}
 
-	// declaring text position and size from the surface
-	SDL_Rect messagePosSize = {x, y,
-							   messageSurface->w,
-							   messageSurface->h};
+	// write a random found word, at the pace given by the skill
+	if(SDL_TICKS_PASSED(SDL_GetTicks(), opponent->nextWordTicks) &&
+	   opponent->numFound > 0 &&
+	   opponent->guessedWordsNum < MAX_GUESSED_WORDS) {
+		size_t j = nextRandom(&opponent->rng) % opponent->numFound;
+		size_t id = opponent->found[j];
+		const char *word = game->assets.words[id];
+		opponent->found[j] = opponent->found[--opponent->numFound];
+
+		// after a restarted search the words already written are found again
+		bool written = false;
+		for(size_t k = 0; k < opponent->guessedWordsNum && !written; k++) {
+			written = strcmp(opponent->guessedWords[k], wordText(&game->assets, id)) == 0;
+		}
+		if(!written) {
+			// the opponent's words are only shown, they are kept as they are written
+			strcpy(opponent->guessedWords[opponent->guessedWordsNum++], wordText(&game->assets, id));
+			opponent->points += wordPoints(POINTS_BY_LENGTH, NUM_POINTS_BY_LENGTH, strlen(word));
+			opponent->nextWordTicks = SDL_GetTicks() + OPPONENT_WORD_TIME_MS * 100 / opponent->skill;
+		}
+	}
 
-	// render the texture with the 
-	SDL_RenderCopy(renderer, messageTexture, NULL, &messagePosSize);
+	// keep track of the time taken from the frame
+	Uint64 stepUs = (SDL_GetPerformanceCounter() - start) * 1000000 / frequency;
+	opponent->totalStepUs += stepUs;
+	opponent->numSteps++;
+	if(stepUs > opponent->maxStepUs) {
+		opponent->maxStepUs = stepUs;
+	}
+	if(stepUs > OPPONENT_FRAME_BUDGET_US) {
+		opponent->overBudgetSteps++;
+	}
+}
 
-	// free texture and surface
-	SDL_FreeSurface(messageSurface);
-	SDL_DestroyTexture(messageTexture);
+void printOpponentReport(const opponent_t *opponent)
+{
+	if(!opponent->enabled || opponent->numSteps == 0) {
+		return;
+	}
+	fprintf(stdout, "Opponent: %zu frames, %.1f us per frame, max %llu us, "
+			"%zu frames over the %d us budget.\n",
+			opponent->numSteps,
+			(double) opponent->totalStepUs / opponent->numSteps,
+			(unsigned long long) opponent->maxStepUs,
+			opponent->overBudgetSteps,
+			OPPONENT_FRAME_BUDGET_US);
 }
 
-void renderBorder(SDL_Renderer *renderer,
-				  const game_t *game,
-				  const SDL_Color color)
+feed_t *openFeed(void)
 {
-	// fill everithing with the color of the border
-	renderRect(renderer, color,
-			   0, 0,
-			   game->screen_width,
-			   game->screen_height);
+	// the spectators of a previous game resynchronize when the feed restarts
+	int fd = shm_open(FEED_SHM_NAME, O_CREAT | O_RDWR, 0644);
+	if(fd < 0 || ftruncate(fd, sizeof(feed_t)) != 0) {
+		fprintf(stderr, "Error: couldn't create the shared memory %s\n", FEED_SHM_NAME);
+		if(fd >= 0) {
+			close(fd);
+		}
+		return NULL;
+	}
+	feed_t *feed = mmap(NULL, sizeof(feed_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(feed == MAP_FAILED) {
+		fprintf(stderr, "Error: couldn't map the shared memory %s\n", FEED_SHM_NAME);
+		return NULL;
+	}
+	memset(feed, 0, sizeof(feed_t));
+	feed->magic = FEED_MAGIC;
+	return feed;
+}
 
-	// fill the center with the color of the background
-	renderRect(renderer, COLOR_GAME_BACKGROUND,
-			   BORDER_THICKNESS, BORDER_THICKNESS,
-			   game->screen_width-2*BORDER_THICKNESS,
-			   game->screen_height-2*BORDER_THICKNESS);
+void publishEvent(feed_t *feed, feedEvents_t type, Sint32 value, const char *text)
+{
+	// only the game writes, so it never waits for the spectators
+	Uint32 n = feed->head.value;
+	feedSlot_t *slot = &feed->slots[n % FEED_SLOTS];
+
+	// a spectator reading the slot meanwhile sees the change of seq and discards it
+	SDL_AtomicSet(&slot->seq, 0);
+	SDL_MemoryBarrierRelease();
+	slot->type = type;
+	slot->value = value;
+	snprintf(slot->text, MAX_WORD_SIZE, "%s", text != NULL ? text : "");
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&slot->seq, n+1);
+	SDL_AtomicSet(&feed->head, n+1);
 }
 
-void renderTextType(SDL_Renderer *renderer,
-					const game_t *game,
-					textTypes_t type,
-					const char *text)
+void publishValue(feed_t *feed, feedEvents_t type, Sint32 *published, Sint32 value)
 {
-	static int num, totHeight;
+	if(*published != value) {
+		*published = value;
+		publishEvent(feed, type, value, NULL);
+	}
+}
 
-	// render text based on the type, incrementing the heigth reached by the other texts
-	switch(type) {
+void publishText(feed_t *feed, feedEvents_t type, char *published, size_t size, const char *text)
+{
+	if(strcmp(published, text) != 0) {
+		snprintf(published, size, "%s", text);
+		publishEvent(feed, type, 0, text);
+	}
+}
 
-	case TEXT_TYPE_MAIN_TITLE: {
-		num = 1;
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_TITLE,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_BOLD],
-				   TEXT_ALIGNMENT_CENTER,
-				   0, 3*BORDER_THICKNESS);
-		totHeight = game->assets.fontSizes[FONT_ROBOTO_BOLD] + 6*BORDER_THICKNESS;
+void publishFeed(game_t *game)
+{
+	feed_t *feed = game->feed;
+	if(feed == NULL) {
+		return;
+	}
+	feedState_t *published = &game->published;
+
+	// only what changed since the last frame is published
+	publishValue(feed, FEED_STATE, &published->state, game->state);
+	publishText(feed, FEED_RACK, published->rack, sizeof(published->rack), game->validCharList);
+	publishValue(feed, FEED_TIME_LEFT, &published->timeLeft, game->timeLeft);
+	publishValue(feed, FEED_POINTS, &published->points, game->points);
+	publishValue(feed, FEED_OPPONENT_POINTS, &published->opponentPoints,
+				 game->opponent.enabled ? game->opponent.points : -1);
+	publishText(feed, FEED_CURRENT_WORD, published->currentWord, MAX_WORD_SIZE, game->currentWord);
+	publishValue(feed, FEED_LAST_WORD, &published->lastWordT, game->lastWordT);
+	while(published->guessedWordsNum < (Sint32) game->guessedWordsNum) {
+		const char *word = wordText(&game->assets, game->guessedIds[published->guessedWordsNum]);
+		strcpy(published->guessedWords[published->guessedWordsNum++], word);
+		publishEvent(feed, FEED_ACCEPTED, published->guessedWordsNum, word);
+	}
+	if(game->longestWordReady && !published->longestWordReady) {
+		published->longestWordReady = true;
+		strcpy(published->longestWord, game->longestWord);
+		publishEvent(feed, FEED_LONGEST_WORD, 0, game->longestWord);
+	}
+
+	// the snapshot is written rarely, it's the only part bigger than a slot
+	if(SDL_TICKS_PASSED(SDL_GetTicks(), game->nextSnapshot) || game->state == GAME_STATE_CLOSE) {
+		SDL_AtomicAdd(&feed->snapshotVersion, 1);
+		SDL_MemoryBarrierRelease();
+		feed->snapshot = *published;
+		feed->snapshotNext = feed->head.value;
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicAdd(&feed->snapshotVersion, 1);
+		game->nextSnapshot = SDL_GetTicks() + FEED_SNAPSHOT_MS;
+	}
+}
+
+Uint32 feedLoad(const SDL_atomic_t *atomic)
+{
+	// the spectators map the feed read only, so they can't use the atomic operations
+	Uint32 value = *(const volatile int *) &atomic->value;
+	SDL_MemoryBarrierAcquire();
+	return value;
+}
+
+bool readFeedSnapshot(const feed_t *feed, feedState_t *state, Uint32 *next)
+{
+	// copy the snapshot, unless the game is writing it
+	Uint32 version = feedLoad(&feed->snapshotVersion);
+	if(version % 2 != 0) {
+		return false;
+	}
+	feedState_t copy = feed->snapshot;
+	Uint32 copyNext = feed->snapshotNext;
+	SDL_MemoryBarrierAcquire();
+	if(feedLoad(&feed->snapshotVersion) != version) {
+		return false;
+	}
+	*state = copy;
+	*next = copyNext;
+	return true;
+}
+
+void applyFeedEvent(feedState_t *state, const feedSlot_t *slot)
+{
+	switch(slot->type) {
+
+	case FEED_STATE: {
+		state->state = slot->value;
 	} break;
 
-	case TEXT_TYPE_SECONDARY_TITLE: {
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_TITLE,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_REGULAR],
-				   TEXT_ALIGNMENT_CENTER,
-				   0, totHeight + 3*BORDER_THICKNESS);
-		totHeight += game->assets.fontSizes[FONT_ROBOTO_REGULAR] + 3*BORDER_THICKNESS;
+	case FEED_RACK: {
+		strcpy(state->rack, slot->text);
 	} break;
 
-	case TEXT_TYPE_NORMAL: {
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_NORMAL,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_REGULAR],
-				   TEXT_ALIGNMENT_LEFT,
-				   0, totHeight + 3*BORDER_THICKNESS);
-		totHeight += game->assets.fontSizes[FONT_ROBOTO_REGULAR] + 3*BORDER_THICKNESS;
+	case FEED_TIME_LEFT: {
+		state->timeLeft = slot->value;
 	} break;
 
-	case TEXT_TYPE_CENTERED: {
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_CENTERED,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_BOLD],
-				   TEXT_ALIGNMENT_CENTER,
-				   0, (game->screen_height-game->assets.fontSizes[FONT_ROBOTO_BOLD])/2);
+	case FEED_POINTS: {
+		state->points = slot->value;
 	} break;
 
-	case TEXT_TYPE_BOTTOM: {
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_NUMBER,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_REGULAR],
-				   TEXT_ALIGNMENT_CENTER,
-				   0, game->screen_height-game->assets.fontSizes[FONT_ROBOTO_BOLD]-3*BORDER_THICKNESS);
+	case FEED_OPPONENT_POINTS: {
+		state->opponentPoints = slot->value;
 	} break;
 
-	case TEXT_TYPE_TIME: {
-		SDL_Color color = {(TIME_MAX - game->timeLeft) * 2, game->timeLeft*2, 0, 255};
-		renderText(renderer,
-				   game,
-				   color,
-				   text,
-				   game->assets.fonts[FONT_SEVEN_SEGMENTS],
-				   TEXT_ALIGNMENT_CENTER,
-				   0, totHeight + 3*BORDER_THICKNESS);
-		totHeight += game->assets.fontSizes[FONT_SEVEN_SEGMENTS] + 3*BORDER_THICKNESS;
+	case FEED_CURRENT_WORD: {
+		strcpy(state->currentWord, slot->text);
 	} break;
 
-	case TEXT_TYPE_RULE: {
-		char numS[10];
-		sprintf(numS, "%d)", num);
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_NUMBER,
-				   numS,
-				   game->assets.fonts[FONT_ROBOTO_REGULAR],
-				   TEXT_ALIGNMENT_LEFT,
-				   0, totHeight + 3*BORDER_THICKNESS);
+	case FEED_LAST_WORD: {
+		state->lastWordT = slot->value;
+	} break;
 
-		int width = getFontWidth(game->assets.fonts[FONT_ROBOTO_REGULAR], numS);
-		renderText(renderer,
-				   game,
-				   COLOR_TEXT_NORMAL,
-				   text,
-				   game->assets.fonts[FONT_ROBOTO_LIGHT],
-				   TEXT_ALIGNMENT_CUSTOM,
-				   6*BORDER_THICKNESS + width, totHeight + 4*BORDER_THICKNESS);
-		totHeight += game->assets.fontSizes[FONT_ROBOTO_LIGHT] + 3*BORDER_THICKNESS;
-		num++;
+	// the value is the number of accepted words
+	case FEED_ACCEPTED: {
+		if(slot->value >= 1 && slot->value <= MAX_GUESSED_WORDS) {
+			strcpy(state->guessedWords[slot->value-1], slot->text);
+			state->guessedWordsNum = slot->value;
+		}
+	} break;
+
+	case FEED_LONGEST_WORD: {
+		strcpy(state->longestWord, slot->text);
+		state->longestWordReady = true;
+	} break;
+
+	default: {
 	} break;
 
 	}
 }
 
-void renderTimeLeft(SDL_Renderer *renderer, const game_t *game)
+bool followFeed(const feed_t *feed, feedState_t *state, Uint32 *next, bool synced)
 {
-	// getting minutes and seconds
-	int minutes = (int) game->timeLeft / 60;
-	int second = (int) game->timeLeft % 60;
+	// returns if the spectator is still in sync with the game
+	if(!synced && !readFeedSnapshot(feed, state, next)) {
+		return false;
+	}
 
-	char time[6];
+	Uint32 head = feedLoad(&feed->head);
+	// the game restarted, or the spectator fell behind by a whole ring
+	if(head < *next || head - *next > FEED_SLOTS) {
+		return false;
+	}
+
+	while(*next < head) {
+		const feedSlot_t *slot = &feed->slots[*next % FEED_SLOTS];
+		if(feedLoad(&slot->seq) != *next+1) {
+			return false;
+		}
+		feedSlot_t copy = *slot;
+		SDL_MemoryBarrierAcquire();
+		// overwritten while it was copied
+		if(feedLoad(&slot->seq) != *next+1) {
+			return false;
+		}
+		applyFeedEvent(state, &copy);
+		(*next)++;
+	}
+	return true;
+}
+
+void showFeedState(game_t *game, const feedState_t *state)
+{
+	// the spectator renders a game made of the published state
+	if(state->state != GAME_STATE_CLOSE) {
+		game->state = state->state;
+	}
+	memcpy(game->validCharList, state->rack, sizeof(game->validCharList));
+	game->timeLeft = state->timeLeft;
+	game->points = state->points;
+	game->opponent.enabled = state->opponentPoints >= 0;
+	game->opponent.points = state->opponentPoints;
+	memcpy(game->currentWord, state->currentWord, MAX_WORD_SIZE);
+	game->lastWordT = state->lastWordT;
+	memcpy(game->longestWord, state->longestWord, MAX_WORD_SIZE);
+	game->longestWordReady = state->longestWordReady;
+}
+
+int runSpectator(void)
+{
+	int fd = shm_open(FEED_SHM_NAME, O_RDONLY, 0);
+	if(fd < 0) {
+		fprintf(stderr, "Error: no game is broadcasting, start one with --broadcast\n");
+		return EXIT_FAILURE;
+	}
+	const feed_t *feed = mmap(NULL, sizeof(feed_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(feed == MAP_FAILED || feed->magic != FEED_MAGIC) {
+		fprintf(stderr, "Error: the shared memory %s isn't a game feed\n", FEED_SHM_NAME);
+		return EXIT_FAILURE;
+	}
+
+	if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+		fprintf(stderr, "SDL_Init Error: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	// only the fonts are needed, the dictionary stays in the game
+	game_t *game = calloc(1, sizeof(game_t));
+	if(game == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the game\n");
+		return EXIT_FAILURE;
+	}
+	game->screen_width = SCREEN_DEFAULT_WIDTH;
+	game->screen_height = SCREEN_DEFAULT_HEIGHT;
+	loadFonts(&game->assets);
+
+	SDL_Window *window = SDL_CreateWindow("Paroliere - spettatore",
+										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+										  game->screen_width, game->screen_height,
+										  SDL_WINDOW_SHOWN |
+										  SDL_WINDOW_RESIZABLE);
+	if(window == NULL) {
+		fprintf(stderr, "SDL_CreateWindow Error: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	SDL_Renderer *renderer = SDL_CreateRenderer(window, -1,
+												SDL_RENDERER_ACCELERATED |
+												SDL_RENDERER_PRESENTVSYNC);
+	if(renderer == NULL) {
+		SDL_DestroyWindow(window);
+		fprintf(stderr, "SDL_CreateRenderer Error: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	SDL_SetWindowMinimumSize(window, SCREEN_MIN_WIDTH, SCREEN_MIN_HEIGHT);
+	uploadFontAtlas(&game->assets, renderer);
+
+	feedState_t state = {0};
+	Uint32 next = 0;
+	bool synced = false;
+	bool quit = false;
+	SDL_Event event;
+
+	while(!quit) {
+		while(SDL_PollEvent(&event)) {
+			if(event.type == SDL_QUIT) {
+				quit = true;
+			} else if(event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
+				SDL_GetWindowSize(window, &game->screen_width, &game->screen_height);
+			}
+		}
+
+		// the game closed and removed the feed, follow the next one when it starts
+		if(state.state == GAME_STATE_CLOSE) {
+			int fd = shm_open(FEED_SHM_NAME, O_RDONLY, 0);
+			if(fd >= 0) {
+				const feed_t *restarted = mmap(NULL, sizeof(feed_t), PROT_READ, MAP_SHARED, fd, 0);
+				close(fd);
+				if(restarted != MAP_FAILED && restarted->magic == FEED_MAGIC) {
+					munmap((void *) feed, sizeof(feed_t));
+					feed = restarted;
+					synced = false;
+				} else if(restarted != MAP_FAILED) {
+					munmap((void *) restarted, sizeof(feed_t));
+				}
+			}
+		}
+
+		// read the events published since the last frame
+		synced = followFeed(feed, &state, &next, synced);
+		showFeedState(game, &state);
+		frame_t frame;
+		snapshotGame(game, &frame);
+
+		SDL_RenderClear(renderer);
+		renderGame(renderer, &frame);
+		SDL_RenderPresent(renderer);
+	}
+
+	munmap((void *) feed, sizeof(feed_t));
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+	free(game);
+	TTF_Quit();
+	SDL_Quit();
+
+	return EXIT_SUCCESS;
+}
+
+void loadFont(assets_t * const assets,
+			  fonts_t fontId,
+			  const char *name,
+			  size_t size)
+{
+	// creating path
+	char path[100] = "./assets/fonts/";
+	strcat(path, name);
+	fprintf(stdout, "Loading font: %s ...\n",path);
+	Uint64 start = SDL_GetPerformanceCounter();
+	// loading font
+	TTF_Font *font = TTF_OpenFont(path, size);
+	if(font == NULL) {
+		fprintf(stderr, "Error: %s", TTF_GetError());
+		exit(EXIT_FAILURE);
+	}
+	// FreeType reads the file as needed, its size is a good estimate of the memory
+	struct stat info;
+	if(stat(path, &info) == 0) {
+		trackMemory(MEMORY_FONTS, info.st_size);
+	}
+	observeLatency(LATENCY_ASSET_LOAD, start);
+	fprintf(stdout, "Font loaded.\n");
+	assets->fonts[fontId] = font;
+	assets->fontSizes[fontId] = size;
+}
+
+Uint16 fontAtlasChar(size_t glyph)
+{
+	size_t numAscii = FONT_ATLAS_LAST_CHAR - FONT_ATLAS_FIRST_CHAR + 1;
+	if(glyph < numAscii) {
+		return FONT_ATLAS_FIRST_CHAR + glyph;
+	}
+	return FONT_ATLAS_EXTRA_CHARS[glyph - numAscii];
+}
+
+void indexFontAtlas(fontAtlas_t *atlas)
+{
+	memset(atlas->glyphOf, '?' - FONT_ATLAS_FIRST_CHAR, sizeof(atlas->glyphOf));
+	for(size_t i = 0; i < FONT_ATLAS_NUM_GLYPHS; i++) {
+		atlas->glyphOf[fontAtlasChar(i)] = i;
+	}
+}
+
+bool loadFontAtlas(assets_t * const assets)
+{
+	fontAtlas_t *atlas = &assets->atlas;
+	FILE *fp = fopen(FONT_ATLAS_FILE, "rb");
+	if(fp == NULL) {
+		return false;
+	}
+	fprintf(stdout, "Loading font atlas: %s ...\n", FONT_ATLAS_FILE);
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	// header, font sizes and glyphs, then the bitmap with one bit for every pixel
+	char magic[4];
+	Uint16 width, height, numGlyphs, sizes[NUM_FONTS];
+	bool ok = fread(magic, sizeof(magic), 1, fp) == 1 &&
+			  memcmp(magic, FONT_ATLAS_MAGIC, sizeof(magic)) == 0 &&
+			  fread(&width, sizeof(width), 1, fp) == 1 &&
+			  fread(&height, sizeof(height), 1, fp) == 1 &&
+			  fread(&numGlyphs, sizeof(numGlyphs), 1, fp) == 1 &&
+			  numGlyphs == FONT_ATLAS_NUM_GLYPHS &&
+			  fread(sizes, sizeof(sizes), 1, fp) == 1 &&
+			  fread(atlas->glyphs, sizeof(atlas->glyphs), 1, fp) == 1;
+
+	size_t rowBytes = (width+7)/8;
+	Uint8 *bits = ok ? allocMemory(MEMORY_FONTS, rowBytes * height) : NULL;
+	ok = bits != NULL && fread(bits, rowBytes * height, 1, fp) == 1;
+	fclose(fp);
+
+	// white pixels, the alpha makes the glyph and the color is set when rendering
+	if(ok) {
+		atlas->surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+		ok = atlas->surface != NULL;
+	}
+	for(size_t y = 0; ok && y < height; y++) {
+		Uint32 *row = (Uint32 *) ((Uint8 *) atlas->surface->pixels + y * atlas->surface->pitch);
+		for(size_t x = 0; x < width; x++) {
+			bool set = bits[y * rowBytes + x/8] & (1 << (x%8));
+			row[x] = set ? 0xFFFFFFFF : 0x00FFFFFF;
+		}
+	}
+	freeMemory(MEMORY_FONTS, bits);
+	// the surface becomes a texture of the same size, kept until the end
+	if(ok) {
+		trackMemory(MEMORY_FONTS, atlas->surface->pitch * atlas->surface->h);
+	}
+
+	if(!ok) {
+		fprintf(stderr, "Error: invalid font atlas %s, loading the fonts\n", FONT_ATLAS_FILE);
+		return false;
+	}
+
+	for(size_t i = 0; i < NUM_FONTS; i++) {
+		assets->fontSizes[i] = sizes[i];
+	}
+	indexFontAtlas(atlas);
+	assets->useAtlas = true;
+	observeLatency(LATENCY_ASSET_LOAD, start);
+	fprintf(stdout, "Font atlas loaded.\n");
+	return true;
+}
+
+void uploadFontAtlas(assets_t * const assets, SDL_Renderer *renderer)
+{
+	fontAtlas_t *atlas = &assets->atlas;
+	if(!assets->useAtlas || atlas->surface == NULL) {
+		return;
+	}
+
+	// a single texture for all the text of the game
+	atlas->texture = SDL_CreateTextureFromSurface(renderer, atlas->surface);
+	if(atlas->texture == NULL) {
+		fprintf(stderr, "SDL_CreateTextureFromSurface Error: %s\n", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+	SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+	SDL_FreeSurface(atlas->surface);
+	atlas->surface = NULL;
+}
+
+int runFontBaking(void)
+{
+	if(TTF_Init() != 0) {
+		fprintf(stderr, "TTF_Init Error: %s\n", TTF_GetError());
+		return EXIT_FAILURE;
+	}
+
+	assets_t *assets = calloc(1, sizeof(assets_t));
+	if(assets == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the assets\n");
+		return EXIT_FAILURE;
+	}
+	fontAtlas_t *atlas = &assets->atlas;
+	SDL_Surface *surfaces[NUM_FONTS][FONT_ATLAS_NUM_GLYPHS];
+	const SDL_Color white = {255, 255, 255, 255};
+
+	// rasterize every glyph and place it on the current shelf of the atlas
+	int x = 0, y = 0, shelfHeight = 0;
+	for(size_t i = 0; i < NUM_FONTS; i++) {
+		loadFont(assets, i, FONT_FILES[i], FONT_SIZES[i]);
+		for(size_t j = 0; j < FONT_ATLAS_NUM_GLYPHS; j++) {
+			Uint16 ch = fontAtlasChar(j);
+			// the glyph is rendered as text, so it's placed like TTF_RenderText_Solid does
+			char text[3] = {ch, '\0', '\0'};
+			if(ch >= 0x80) {
+				text[0] = 0xC0 | (ch >> 6);
+				text[1] = 0x80 | (ch & 0x3F);
+			}
+			int advance = 0;
+			TTF_GlyphMetrics(assets->fonts[i], ch, NULL, NULL, NULL, NULL, &advance);
+			SDL_Surface *surface = TTF_RenderUTF8_Solid(assets->fonts[i], text, white);
+			if(surface != NULL && surface->format->BytesPerPixel != 1) {
+				fprintf(stderr, "Error: unexpected glyph format\n");
+				return EXIT_FAILURE;
+			}
+			surfaces[i][j] = surface;
+
+			int w = surface != NULL ? surface->w : 0;
+			int h = surface != NULL ? surface->h : 0;
+			if(x + w > FONT_ATLAS_WIDTH) {
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+			glyph_t glyph = {x, y, w, h, advance};
+			atlas->glyphs[i][j] = glyph;
+			x += w;
+			if(h > shelfHeight) {
+				shelfHeight = h;
+			}
+		}
+	}
+
+	// pack the glyphs, one bit for every pixel
+	Uint16 width = FONT_ATLAS_WIDTH, height = y + shelfHeight, numGlyphs = FONT_ATLAS_NUM_GLYPHS;
+	size_t rowBytes = (width+7)/8;
+	Uint8 *bits = calloc(rowBytes * height, 1);
+	if(bits == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the atlas\n");
+		return EXIT_FAILURE;
+	}
+	for(size_t i = 0; i < NUM_FONTS; i++) {
+		for(size_t j = 0; j < FONT_ATLAS_NUM_GLYPHS; j++) {
+			SDL_Surface *surface = surfaces[i][j];
+			if(surface == NULL) {
+				continue;
+			}
+			SDL_LockSurface(surface);
+			for(int py = 0; py < surface->h; py++) {
+				for(int px = 0; px < surface->w; px++) {
+					// in solid surfaces the color index 0 is the background
+					if(((Uint8 *) surface->pixels)[py * surface->pitch + px] != 0) {
+						size_t ax = atlas->glyphs[i][j].x + px, ay = atlas->glyphs[i][j].y + py;
+						bits[ay * rowBytes + ax/8] |= 1 << (ax%8);
+					}
+				}
+			}
+			SDL_UnlockSurface(surface);
+			SDL_FreeSurface(surface);
+		}
+	}
+
+	Uint16 sizes[NUM_FONTS];
+	for(size_t i = 0; i < NUM_FONTS; i++) {
+		sizes[i] = FONT_SIZES[i];
+	}
+
+	FILE *fp = fopen(FONT_ATLAS_FILE, "wb");
+	bool ok = fp != NULL &&
+			  fwrite(FONT_ATLAS_MAGIC, 4, 1, fp) == 1 &&
+			  fwrite(&width, sizeof(width), 1, fp) == 1 &&
+			  fwrite(&height, sizeof(height), 1, fp) == 1 &&
+			  fwrite(&numGlyphs, sizeof(numGlyphs), 1, fp) == 1 &&
+			  fwrite(sizes, sizeof(sizes), 1, fp) == 1 &&
+			  fwrite(atlas->glyphs, sizeof(atlas->glyphs), 1, fp) == 1 &&
+			  fwrite(bits, rowBytes * height, 1, fp) == 1;
+	if(fp != NULL) {
+		ok = fclose(fp) == 0 && ok;
+	}
+	free(bits);
+	free(assets);
+	TTF_Quit();
+
+	if(!ok) {
+		fprintf(stderr, "Error: couldn't write %s\n", FONT_ATLAS_FILE);
+		return EXIT_FAILURE;
+	}
+	fprintf(stdout, "Baked %d glyphs in a %dx%d atlas: %s\n",
+			NUM_FONTS * FONT_ATLAS_NUM_GLYPHS, width, height, FONT_ATLAS_FILE);
+	return EXIT_SUCCESS;
+}
+
+void loadAudio(assets_t * const assets,
+			  audios_t audioId,
+			  const char *name)
+{
+	// creating path
+	char path[100] = "./assets/sounds/";
+	strcat(path, name);
+	fprintf(stdout, "Loading sound: %s ...\n",path);
+	Uint64 start = SDL_GetPerformanceCounter();
+	// loading audio
+	Mix_Chunk *sound = Mix_LoadWAV(path);
+	if(sound == NULL)
+	{
+		fprintf(stderr, "Error: %s", Mix_GetError());
+		exit(EXIT_FAILURE);
+	}
+	assets->sounds[audioId] = sound;
+	// the samples are decoded to the format of the device
+	trackMemory(MEMORY_AUDIO, sizeof(Mix_Chunk) + sound->alen);
+	observeLatency(LATENCY_ASSET_LOAD, start);
+	fprintf(stdout, "Sound loaded.\n");
+}
+
+void loadText(assets_t * const assets, const char *name)
+{
+	size_t num = assets->numWords;
+	// creating path
+	char path[100] = TEXTS_DIR;
+	strcat(path, name);
+	fprintf(stdout, "Loading texts: %s ...\n",path);
+	Uint64 start = SDL_GetPerformanceCounter();
+	// opening file
+	FILE *fp = fopen(path, "r");
+	if(fp == NULL) {
+		fprintf(stderr, "Error: couldn't load file: %s", path);
+		exit(EXIT_FAILURE);
+	}
+	// loading word until the end of file, or until max num of words reached
+	char word[MAX_WORD_SIZE];
+	while(assets->numWords < MAX_WORDS && fgets(word, MAX_WORD_SIZE-1, fp)) {
+		// removing any line terminator
+		char *ptr = strchr(word, '\r');
+		if(ptr != NULL) {
+			*ptr = '\0';
+		}
+		ptr = strchr(word, '\n');
+		if(ptr != NULL) {
+			*ptr = '\0';
+		}
+		// the words with accents are matched without them, but shown as they are written
+		size_t id = assets->numWords++;
+		if(normalizeWord(word, assets->words[id], MAX_WORD_SIZE) &&
+		   assets->numAccented < MAX_ACCENTED_WORDS) {
+			assets->accented[assets->numAccented].id = id;
+			strcpy(assets->accented[assets->numAccented++].text, word);
+		}
+	}
+	fclose(fp);
+	observeLatency(LATENCY_ASSET_LOAD, start);
+	fprintf(stdout, "Loaded %zu words.\n", assets->numWords - num);
+}
+
+void loadFonts(assets_t * const assets)
+{
+	// the baked atlas doesn't need FreeType, the fonts are the fallback
+	if(!loadFontAtlas(assets)) {
+		if(TTF_Init() != 0) {
+			fprintf(stderr, "TTF_Init Error: %s\n", TTF_GetError());
+			exit(EXIT_FAILURE);
+		}
+		for(size_t i = 0; i < NUM_FONTS; i++) {
+			loadFont(assets, i, FONT_FILES[i], FONT_SIZES[i]);
+		}
+	}
+}
+
+void loadAssets(assets_t * const assets, jobPool_t *jobs)
+{
+	// loading all assets
+
+	// the dictionary is the slowest, it's loaded by the workers meanwhile
+	dictionaryTask_t dictionary = {.assets = assets, .jobs = jobs};
+	initJob(&dictionary.job, loadDictionaryJob, NULL, &dictionary);
+	submitJob(jobs, &dictionary.job);
+
+	loadFonts(assets);
+
+	loadAudio(assets, AUDIO_TIC, "tic.wav");
+	loadAudio(assets, AUDIO_TAC, "tac.wav");
+	loadAudio(assets, AUDIO_CORRECT, "correct.wav");
+	loadAudio(assets, AUDIO_INCORRECT, "incorrect.wav");
+
+	waitJob(jobs, &dictionary.job);
+}
+
+void loadDictionary(assets_t * const assets, jobPool_t *jobs)
+{
+	// room for the most words, reduced to the loaded ones
+	assets->words = allocMemory(MEMORY_DICTIONARY, MAX_WORDS * MAX_WORD_SIZE);
+	assets->accented = allocMemory(MEMORY_DICTIONARY, MAX_ACCENTED_WORDS * sizeof(accentedWord_t));
+	if(assets->words == NULL || assets->accented == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+		exit(EXIT_FAILURE);
+	}
+
+	loadText(assets, "words.txt");
+	loadText(assets, "words2.txt");
+	assets->overlay.numListWords = assets->numWords;
+
+	assets->words = reallocMemory(MEMORY_DICTIONARY, assets->words, assets->numWords * MAX_WORD_SIZE + 1);
+	assets->accented = reallocMemory(MEMORY_DICTIONARY, assets->accented,
+									 assets->numAccented * sizeof(accentedWord_t) + 1);
+	assets->wordMasks = allocMemory(MEMORY_DICTIONARY, assets->numWords * sizeof(Uint32) + 1);
+	assets->wordCounts = allocMemory(MEMORY_DICTIONARY, assets->numWords * sizeof(letterCounts_t) + 1);
+	if(assets->words == NULL || assets->accented == NULL ||
+	   assets->wordMasks == NULL || assets->wordCounts == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+		exit(EXIT_FAILURE);
+	}
+	assets->overlay.wordsCapacity = assets->numWords;
+	assets->overlay.accentedCapacity = assets->numAccented;
+	indexDictionary(assets, jobs);
+
+	// the words of the user, compacted in a list and then in the overlay
+	loadUserWords(assets);
+	readOverlay(assets);
+
+	// what the words would take in other formats
+	size_t packed = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		packed += strlen(assets->words[i]) + 1 + sizeof(Uint32);
+	}
+	fprintf(stdout, "Dictionary: %.2f MB in rows of %d bytes, %.2f MB with room for %d words, "
+			"%.2f MB as packed strings with offsets\n",
+			assets->numWords * MAX_WORD_SIZE / 1048576.0, MAX_WORD_SIZE,
+			MAX_WORDS * MAX_WORD_SIZE / 1048576.0, MAX_WORDS, packed / 1048576.0);
+}
+
+void loadDictionaryJob(void *data)
+{
+	dictionaryTask_t *task = data;
+	loadDictionary(task->assets, task->jobs);
+}
+
+void freeDictionary(assets_t * const assets)
+{
+	freeMemory(MEMORY_DICTIONARY, assets->words);
+	freeMemory(MEMORY_DICTIONARY, assets->accented);
+	freeMemory(MEMORY_DICTIONARY, assets->wordMasks);
+	freeMemory(MEMORY_DICTIONARY, assets->wordCounts);
+	freeMemory(MEMORY_DICTIONARY, assets->overlay.table);
+	assets->overlay = (overlay_t) {0};
+	assets->words = NULL;
+	assets->accented = NULL;
+	assets->wordMasks = NULL;
+	assets->wordCounts = NULL;
+	assets->numWords = 0;
+	assets->numAccented = 0;
+}
+
+void indexDictionary(assets_t * const assets, jobPool_t *jobs)
+{
+	// the letter masks and counts are computed in parallel, in chunks of words
+	size_t numChunks = (assets->numWords + INDEX_CHUNK_WORDS - 1) / INDEX_CHUNK_WORDS;
+	indexChunk_t *chunks = allocMemory(MEMORY_DICTIONARY, sizeof(indexChunk_t) * numChunks);
+	if(chunks == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary index\n");
+		exit(EXIT_FAILURE);
+	}
+	for(size_t i = 0; i < numChunks; i++) {
+		chunks[i].assets = assets;
+		chunks[i].start = i * INDEX_CHUNK_WORDS;
+		chunks[i].end = chunks[i].start + INDEX_CHUNK_WORDS;
+		if(chunks[i].end > assets->numWords) {
+			chunks[i].end = assets->numWords;
+		}
+		initJob(&chunks[i].job, indexChunkJob, NULL, &chunks[i]);
+		if(jobs != NULL) {
+			submitJob(jobs, &chunks[i].job);
+		} else {
+			indexChunkJob(&chunks[i]);
+		}
+	}
+
+	for(size_t i = 0; jobs != NULL && i < numChunks; i++) {
+		waitJob(jobs, &chunks[i].job);
+	}
+	freeMemory(MEMORY_DICTIONARY, chunks);
+}
+
+void indexChunkJob(void *data)
+{
+	indexChunk_t *chunk = data;
+	for(size_t i = chunk->start; i < chunk->end; i++) {
+		chunk->assets->wordMasks[i] = letterMask(chunk->assets->words[i]);
+		chunk->assets->wordCounts[i] = letterCounts(chunk->assets->words[i]);
+	}
+}
+
+void buildWordTable(assets_t * const assets)
+{
+	overlay_t *overlay = &assets->overlay;
+	// at most half full, so the probe sequences stay short
+	size_t size = 16;
+	while(size < 2 * (assets->numWords+1)) {
+		size *= 2;
+	}
+	freeMemory(MEMORY_DICTIONARY, overlay->table);
+	overlay->table = allocMemory(MEMORY_DICTIONARY, sizeof(Uint32) * size);
+	if(overlay->table == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary table\n");
+		exit(EXIT_FAILURE);
+	}
+	overlay->tableSize = size;
+	overlay->tableUsed = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		insertWord(assets, i);
+	}
+}
+
+void insertWord(assets_t * const assets, Uint32 id)
+{
+	// the copies of a word are after the first one in its probe sequence
+	overlay_t *overlay = &assets->overlay;
+	size_t slot = hashWord(assets->words[id]) & (overlay->tableSize-1);
+	while(overlay->table[slot] != 0) {
+		slot = (slot+1) & (overlay->tableSize-1);
+	}
+	overlay->table[slot] = id+1;
+	overlay->tableUsed++;
+}
+
+Sint32 findDictionaryWord(const assets_t *assets, const char *word)
+{
+	// id of the first copy of the word, -1 if it isn't in the dictionary
+	const overlay_t *overlay = &assets->overlay;
+	size_t slot = hashWord(word) & (overlay->tableSize-1);
+	while(overlay->table[slot] != 0) {
+		Uint32 id = overlay->table[slot]-1;
+		if(strcmp(assets->words[id], word) == 0) {
+			return id;
+		}
+		slot = (slot+1) & (overlay->tableSize-1);
+	}
+	return -1;
+}
+
+bool userWord(const char *text, char *word)
+{
+	// the user can add only words that can be typed
+	if(strlen(text) >= MAX_WORD_SIZE) {
+		return false;
+	}
+	normalizeWord(text, word, MAX_WORD_SIZE);
+	return word[0] != '\0' && (letterMask(word) & LETTER_INVALID_BIT) == 0;
+}
+
+bool applyOverlayWord(assets_t * const assets, bool add, const char *text)
+{
+	// returns if the dictionary changed, applying a line again doesn't change it
+	char word[MAX_WORD_SIZE];
+	if(!userWord(text, word)) {
+		return false;
+	}
+	overlay_t *overlay = &assets->overlay;
+	if(overlay->table == NULL) {
+		buildWordTable(assets);
+	}
+
+	// every copy of the word is removed or brought back, the removed words never match a rack
+	Uint32 mask = letterMask(word);
+	if(!add) {
+		mask |= LETTER_INVALID_BIT | LETTER_REMOVED_BIT;
+	}
+	bool found = false, changed = false;
+	size_t slot = hashWord(word) & (overlay->tableSize-1);
+	while(overlay->table[slot] != 0) {
+		Uint32 id = overlay->table[slot]-1;
+		if(strcmp(assets->words[id], word) == 0) {
+			found = true;
+			changed |= assets->wordMasks[id] != mask;
+			assets->wordMasks[id] = mask;
+		}
+		slot = (slot+1) & (overlay->tableSize-1);
+	}
+	if(found || !add) {
+		return changed;
+	}
+
+	// a new word, after the others so the ids don't change
+	if(assets->numWords == overlay->wordsCapacity) {
+		size_t capacity = overlay->wordsCapacity + overlay->wordsCapacity/8 + 64;
+		assets->words = reallocMemory(MEMORY_DICTIONARY, assets->words, capacity * MAX_WORD_SIZE);
+		assets->wordMasks = reallocMemory(MEMORY_DICTIONARY, assets->wordMasks, capacity * sizeof(Uint32));
+		assets->wordCounts = reallocMemory(MEMORY_DICTIONARY, assets->wordCounts, capacity * sizeof(letterCounts_t));
+		if(assets->words == NULL || assets->wordMasks == NULL || assets->wordCounts == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+			exit(EXIT_FAILURE);
+		}
+		overlay->wordsCapacity = capacity;
+	}
+	Uint32 id = assets->numWords++;
+	strcpy(assets->words[id], word);
+	assets->wordMasks[id] = mask;
+	assets->wordCounts[id] = letterCounts(word);
+	// shown as it is written if it has accents, like the words of the lists
+	if(normalizeWord(text, word, sizeof(word))) {
+		if(assets->numAccented == overlay->accentedCapacity) {
+			size_t capacity = overlay->accentedCapacity + overlay->accentedCapacity/8 + 64;
+			assets->accented = reallocMemory(MEMORY_DICTIONARY, assets->accented, capacity * sizeof(accentedWord_t));
+			if(assets->accented == NULL) {
+				fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+				exit(EXIT_FAILURE);
+			}
+			overlay->accentedCapacity = capacity;
+		}
+		assets->accented[assets->numAccented].id = id;
+		strcpy(assets->accented[assets->numAccented++].text, text);
+	}
+
+	if(2 * (overlay->tableUsed+1) > overlay->tableSize) {
+		buildWordTable(assets);
+	} else {
+		insertWord(assets, id);
+	}
+	return true;
+}
+
+void loadUserWords(assets_t * const assets)
+{
+	// same format of the lists, but the words can be more than the room left in them
+	FILE *fp = fopen(TEXTS_DIR USER_WORDS_FILE, "r");
+	if(fp == NULL) {
+		return;
+	}
+	char line[4*MAX_WORD_SIZE];
+	size_t num = 0;
+	while(fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		num += applyOverlayWord(assets, true, line);
+	}
+	fclose(fp);
+	fprintf(stdout, "Loaded %zu words of the user.\n", num);
+}
+
+bool readOverlay(assets_t * const assets)
+{
+	// applies the lines appended since the last time, returns if the dictionary changed
+	overlay_t *overlay = &assets->overlay;
+	FILE *fp = fopen(TEXTS_DIR OVERLAY_FILE, "r");
+	if(fp == NULL) {
+		return false;
+	}
+	struct stat info;
+	if(fstat(fileno(fp), &info) != 0) {
+		fclose(fp);
+		return false;
+	}
+	// compacted or rewritten, the lines already applied don't change anything
+	if(info.st_ino != overlay->inode || info.st_size < overlay->offset) {
+		overlay->inode = info.st_ino;
+		overlay->offset = 0;
+	}
+	if(info.st_size == overlay->offset || fseeko(fp, overlay->offset, SEEK_SET) != 0) {
+		fclose(fp);
+		return false;
+	}
+
+	bool changed = false;
+	char line[4*MAX_WORD_SIZE];
+	while(fgets(line, sizeof(line), fp)) {
+		size_t len = strlen(line);
+		if(line[len-1] != '\n') {
+			// the last line is still being written, it's read the next time
+			if(feof(fp)) {
+				break;
+			}
+			// too long to be a word
+			int ch;
+			while((ch = fgetc(fp)) != EOF && ch != '\n');
+			if(ch == EOF) {
+				break;
+			}
+		} else {
+			line[strcspn(line, "\r\n")] = '\0';
+			// +WORD adds the word or brings it back, -WORD removes it
+			if((line[0] == '+' || line[0] == '-') && applyOverlayWord(assets, line[0] == '+', line+1)) {
+				changed = true;
+				overlay->pending++;
+			}
+		}
+		overlay->offset = ftello(fp);
+	}
+	fclose(fp);
+	return changed;
+}
+
+void pollOverlay(game_t *game)
+{
+	if(!SDL_TICKS_PASSED(SDL_GetTicks(), game->nextOverlayPoll)) {
+		return;
+	}
+	game->nextOverlayPoll = SDL_GetTicks() + OVERLAY_POLL_MS;
+
+	// the dictionary can't change while the longest word is searched
+	if(game->longestWordJob.run != NULL && !SDL_AtomicGet(&game->longestWordJob.done)) {
+		return;
+	}
+	// the words take effect in the round being played
+	if(readOverlay(&game->assets) && game->state == GAME_STATE_RUNNING) {
+		buildWorkingSet(game);
+		// the opponent's search was walking the old set
+		restartOpponentSearch(&game->opponent);
+	}
+	if(game->assets.overlay.pending >= OVERLAY_COMPACT_LINES && !game->compaction.running) {
+		compactOverlay(game);
+	}
+}
+
+void compactOverlay(game_t *game)
+{
+	const assets_t *assets = &game->assets;
+	overlayCompaction_t *compaction = &game->compaction;
+
+	// the added words go in a list like the ones of the game, the removed words stay in the overlay,
+	// the removed user words stay in the list too so the ids of the history keep their words
+	size_t numListWords = assets->overlay.numListWords;
+	size_t numRemoved = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		numRemoved += (assets->wordMasks[i] & LETTER_REMOVED_BIT) != 0;
+	}
+	compaction->userWords = allocMemory(MEMORY_DICTIONARY, (assets->numWords - numListWords) * (MAX_WORD_SIZE+1) + 1);
+	compaction->removed = allocMemory(MEMORY_DICTIONARY, numRemoved * (MAX_WORD_SIZE+2) + 1);
+	if(compaction->userWords == NULL || compaction->removed == NULL) {
+		fprintf(stderr, "Error: couldn't compact the overlay\n");
+		overlayCompacted(compaction);
+		return;
+	}
+	compaction->userSize = 0;
+	for(size_t i = numListWords; i < assets->numWords; i++) {
+		compaction->userSize += sprintf(compaction->userWords + compaction->userSize, "%s\n", wordText(assets, i));
+	}
+	compaction->removedSize = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		// the words in both lists are written once
+		if((assets->wordMasks[i] & LETTER_REMOVED_BIT) != 0 && findDictionaryWord(assets, assets->words[i]) == (Sint32) i) {
+			compaction->removedSize += sprintf(compaction->removed + compaction->removedSize, "-%s\n", wordText(assets, i));
+		}
+	}
+	compaction->offset = assets->overlay.offset;
+	game->assets.overlay.pending = 0;
+
+	compaction->running = true;
+	initJob(&compaction->job, compactOverlayJob, overlayCompacted, compaction);
+	submitJob(game->jobs, &compaction->job);
+}
+
+void compactOverlayJob(void *data)
+{
+	overlayCompaction_t *compaction = data;
+
+	// the editors append under the same lock, so no line is lost while the files are replaced,
+	// it's not inherited or a child process would keep it
+	int fd = open(TEXTS_DIR OVERLAY_FILE, O_RDONLY | O_CLOEXEC);
+	if(fd < 0 || flock(fd, LOCK_EX) != 0) {
+		fprintf(stderr, "Error: couldn't compact the overlay\n");
+		if(fd >= 0) {
+			close(fd);
+		}
+		return;
+	}
+	struct stat info;
+	char *tail = NULL;
+	size_t tailSize = 0;
+	bool ok = fstat(fd, &info) == 0;
+	if(ok && info.st_size > compaction->offset) {
+		tailSize = info.st_size - compaction->offset;
+		tail = malloc(tailSize);
+		ok = tail != NULL && pread(fd, tail, tailSize, compaction->offset) == (ssize_t) tailSize;
+	}
+
+	// the list first, if the overlay isn't replaced its lines are applied again without changes
+	ok = ok &&
+		 replaceFile(TEXTS_DIR USER_WORDS_FILE, compaction->userWords, compaction->userSize, NULL, 0) &&
+		 replaceFile(TEXTS_DIR OVERLAY_FILE, compaction->removed, compaction->removedSize, tail, tailSize);
+	if(!ok) {
+		fprintf(stderr, "Error: couldn't compact the overlay\n");
+	}
+	free(tail);
+	close(fd);
+}
+
+void overlayCompacted(void *data)
+{
+	overlayCompaction_t *compaction = data;
+	freeMemory(MEMORY_DICTIONARY, compaction->userWords);
+	freeMemory(MEMORY_DICTIONARY, compaction->removed);
+	compaction->userWords = NULL;
+	compaction->removed = NULL;
+	compaction->running = false;
+}
+
+int runOverlayEdit(int argc, char *argv[])
+{
+	// check every word first, so a wrong one doesn't leave the others written
+	char word[MAX_WORD_SIZE];
+	for(int i = 0; i < argc; i++) {
+		if((argv[i][0] != '+' && argv[i][0] != '-') || !userWord(argv[i]+1, word)) {
+			fprintf(stderr, "Invalid word: %s (+WORD to add it, -WORD to remove it)\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// a game may be compacting the overlay, the lines go in the file that replaced it
+	int fd;
+	for(;;) {
+		fd = open(TEXTS_DIR OVERLAY_FILE, O_WRONLY | O_APPEND | O_CREAT, 0644);
+		if(fd < 0 || flock(fd, LOCK_EX) != 0) {
+			fprintf(stderr, "Error: couldn't open the overlay %s\n", TEXTS_DIR OVERLAY_FILE);
+			return EXIT_FAILURE;
+		}
+		struct stat opened, current;
+		if(fstat(fd, &opened) == 0 && stat(TEXTS_DIR OVERLAY_FILE, &current) == 0 &&
+		   opened.st_ino == current.st_ino) {
+			break;
+		}
+		close(fd);
+	}
+
+	// whole lines, so the games never read half a word
+	bool ok = true;
+	for(int i = 0; i < argc && ok; i++) {
+		char line[MAX_WORD_SIZE+2];
+		int len = snprintf(line, sizeof(line), "%s\n", argv[i]);
+		ok = writeAll(fd, line, len);
+	}
+	ok = close(fd) == 0 && ok;
+	if(!ok) {
+		fprintf(stderr, "Error: couldn't write the overlay %s\n", TEXTS_DIR OVERLAY_FILE);
+		return EXIT_FAILURE;
+	}
+	fprintf(stdout, "%d words written in the overlay.\n", argc);
+	return EXIT_SUCCESS;
+}
+
+void freeAudio(Mix_Chunk *sounds[NUM_AUDIO]) {
+	for(size_t i = 0; i < NUM_AUDIO; i++) {
+		if(sounds[i] != NULL) {
+			trackMemory(MEMORY_AUDIO, -(Sint64) (sizeof(Mix_Chunk) + sounds[i]->alen));
+		}
+		Mix_FreeChunk(sounds[i]);
+	}
+}
+
+void playSound(Mix_Chunk *sound) {
+	// play sound in the default channel
+	Mix_PlayChannel(-1, sound, 0);
+}
+
+void renderRect(SDL_Renderer *renderer,
+				SDL_Color color,
+				int x, int y,
+				int width, int height)
+{
+	// set color
+	COLOR_SET(renderer, color);
+	// declare rectangle
+	SDL_Rect b = {x, y, width, height};
+	// render rectangle
+	SDL_RenderFillRect(renderer, &b);
+}
+
+
+void renderText(SDL_Renderer *renderer,
+				const frame_t *frame, 
+				SDL_Color color,
+				const char *text,
+				fonts_t font,
+				alignment_t alignment,
+				int x, int y)
+{
+	int width = textWidth(frame->assets, font, text);
+
+	// calculating x based on the alignment
+	switch(alignment) {
+
+	case TEXT_ALIGNMENT_LEFT: {
+		x = 4*BORDER_THICKNESS;
+	} break;
+
+	case TEXT_ALIGNMENT_CENTER: {
+		x = (frame->screen_width-width)/2;
+	} break;
+
+	case TEXT_ALIGNMENT_RIGHT: {
+		x = frame->screen_width-width-4*BORDER_THICKNESS;
+	} break;
+
+	// x remains the same for custom alignment
+	case TEXT_ALIGNMENT_CUSTOM: {
+	} break;
+
+	default: {
+	} break;
+
+	}
+
+	// copy every glyph from the atlas, tinted with the color
+	if(frame->assets->useAtlas) {
+		const fontAtlas_t *atlas = &frame->assets->atlas;
+		SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+		// the text is utf-8, the atlas has the glyphs of latin-1
+		while(*text != '\0') {
+			const glyph_t *glyph = &atlas->glyphs[font][atlas->glyphOf[nextLatin1(&text)]];
+			SDL_Rect source = {glyph->x, glyph->y, glyph->w, glyph->h};
+			SDL_Rect destination = {x, y, glyph->w, glyph->h};
+			SDL_RenderCopy(renderer, atlas->texture, &source, &destination);
+			x += glyph->advance;
+		}
+		return;
+	}
+
+	// create text surface
+	SDL_Surface* messageSurface = TTF_RenderUTF8_Solid(frame->assets->fonts[font], text, color);
+
+	trackMemory(MEMORY_TEXT, messageSurface->pitch * messageSurface->h);
+
+	// create texture from surface
+	SDL_Texture* messageTexture = SDL_CreateTextureFromSurface(renderer, messageSurface);
+
+	// declaring text position and size from the surface
+	SDL_Rect messagePosSize = {x, y,
+							   messageSurface->w,
+							   messageSurface->h};
+
+	// render the texture with the 
+	SDL_RenderCopy(renderer, messageTexture, NULL, &messagePosSize);
+
+	// free texture and surface
+	trackMemory(MEMORY_TEXT, -messageSurface->pitch * messageSurface->h);
+	SDL_FreeSurface(messageSurface);
+	SDL_DestroyTexture(messageTexture);
+}
+
+void renderBorder(SDL_Renderer *renderer,
+				  const frame_t *frame,
+				  const SDL_Color color)
+{
+	// fill everithing with the color of the border
+	renderRect(renderer, color,
+			   0, 0,
+			   frame->screen_width,
+			   frame->screen_height);
+
+	// fill the center with the color of the background
+	renderRect(renderer, COLOR_GAME_BACKGROUND,
+			   BORDER_THICKNESS, BORDER_THICKNESS,
+			   frame->screen_width-2*BORDER_THICKNESS,
+			   frame->screen_height-2*BORDER_THICKNESS);
+}
+
+void renderTextType(SDL_Renderer *renderer,
+					const frame_t *frame,
+					textTypes_t type,
+					const char *text)
+{
+	static int num, totHeight;
+
+	// render text based on the type, incrementing the heigth reached by the other texts
+	switch(type) {
+
+	case TEXT_TYPE_MAIN_TITLE: {
+		num = 1;
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_TITLE,
+				   text,
+				   FONT_ROBOTO_BOLD,
+				   TEXT_ALIGNMENT_CENTER,
+				   0, 3*BORDER_THICKNESS);
+		totHeight = frame->assets->fontSizes[FONT_ROBOTO_BOLD] + 6*BORDER_THICKNESS;
+	} break;
+
+	case TEXT_TYPE_SECONDARY_TITLE: {
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_TITLE,
+				   text,
+				   FONT_ROBOTO_REGULAR,
+				   TEXT_ALIGNMENT_CENTER,
+				   0, totHeight + 3*BORDER_THICKNESS);
+		totHeight += frame->assets->fontSizes[FONT_ROBOTO_REGULAR] + 3*BORDER_THICKNESS;
+	} break;
+
+	case TEXT_TYPE_NORMAL: {
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_NORMAL,
+				   text,
+				   FONT_ROBOTO_REGULAR,
+				   TEXT_ALIGNMENT_LEFT,
+				   0, totHeight + 3*BORDER_THICKNESS);
+		totHeight += frame->assets->fontSizes[FONT_ROBOTO_REGULAR] + 3*BORDER_THICKNESS;
+	} break;
+
+	case TEXT_TYPE_CENTERED: {
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_CENTERED,
+				   text,
+				   FONT_ROBOTO_BOLD,
+				   TEXT_ALIGNMENT_CENTER,
+				   0, (frame->screen_height-frame->assets->fontSizes[FONT_ROBOTO_BOLD])/2);
+	} break;
+
+	case TEXT_TYPE_BOTTOM: {
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_NUMBER,
+				   text,
+				   FONT_ROBOTO_REGULAR,
+				   TEXT_ALIGNMENT_CENTER,
+				   0, frame->screen_height-frame->assets->fontSizes[FONT_ROBOTO_BOLD]-3*BORDER_THICKNESS);
+	} break;
+
+	case TEXT_TYPE_TIME: {
+		SDL_Color color = {(TIME_MAX - frame->timeLeft) * 2, frame->timeLeft*2, 0, 255};
+		renderText(renderer,
+				   frame,
+				   color,
+				   text,
+				   FONT_SEVEN_SEGMENTS,
+				   TEXT_ALIGNMENT_CENTER,
+				   0, totHeight + 3*BORDER_THICKNESS);
+		totHeight += frame->assets->fontSizes[FONT_SEVEN_SEGMENTS] + 3*BORDER_THICKNESS;
+	} break;
+
+	case TEXT_TYPE_RULE: {
+		char numS[10];
+		sprintf(numS, "%d)", num);
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_NUMBER,
+				   numS,
+				   FONT_ROBOTO_REGULAR,
+				   TEXT_ALIGNMENT_LEFT,
+				   0, totHeight + 3*BORDER_THICKNESS);
+
+		int width = textWidth(frame->assets, FONT_ROBOTO_REGULAR, numS);
+		renderText(renderer,
+				   frame,
+				   COLOR_TEXT_NORMAL,
+				   text,
+				   FONT_ROBOTO_LIGHT,
+				   TEXT_ALIGNMENT_CUSTOM,
+				   6*BORDER_THICKNESS + width, totHeight + 4*BORDER_THICKNESS);
+		totHeight += frame->assets->fontSizes[FONT_ROBOTO_LIGHT] + 3*BORDER_THICKNESS;
+		num++;
+	} break;
+
+	}
+}
+
+void renderTimeLeft(SDL_Renderer *renderer, const frame_t *frame)
+{
+	// getting minutes and seconds
+	int minutes = (int) frame->timeLeft / 60;
+	int second = (int) frame->timeLeft % 60;
+
+	char time[6];
 	// pretty printing (MM:SS) string
 	sprintf(time, "%02d:%02d", minutes, second);
 
-	// get time text width
-	int textWidth;
-	TTF_SizeText(game->assets.fonts[FONT_SEVEN_SEGMENTS],
-				 time, &textWidth, NULL);
-	// render time
-	renderTextType(renderer,
-			   game,
-			   TEXT_TYPE_TIME,
-			   time);
+	// render time
+	renderTextType(renderer,
+			   frame,
+			   TEXT_TYPE_TIME,
+			   time);
+}
+
+
+void renderLoadingState(SDL_Renderer *renderer, const frame_t *frame)
+{
+	renderBorder(renderer, frame, COLOR_GAME_LOADING_BORDER);
+
+	// render welcome message
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_MAIN_TITLE,
+				   "Benvenuto a Paroliere");
+
+	// render rule title
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_NORMAL,
+				   "Regole:");
+
+	// rule list
+	const char *rules[] = {
+		"- Scegli 10 tra vocali e consonanti;",
+		"- Devi formare parole con le lettere generate;",
+		frame->multiset ? "- Puoi utilizzare ogni lettera quante volte è uscita;"
+					   : "- Puoi utilizzare le lettere varie volte;",
+		"- Hai 120 secondi.",
+	};
+	// calculating number of rules
+	size_t numRules = sizeof(rules)/sizeof(char*);
+	// renderering every rule
+	for(size_t i=0;i<numRules;i++) {
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   rules[i]);
+	}
+	if(frame->maxBlanks > 0) {
+		char rule[100];
+		sprintf(rule, "- Puoi prendere %d jolly (?), valgono una lettera a scelta.", frame->maxBlanks);
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   rule);
+	}
+
+	// render instruction for next game state and exit
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_BOTTOM,
+				   "Premi [INVIO] per continuare, [Q] per uscire");
+
+}
+
+void renderChoosingLettersState(SDL_Renderer *renderer, const frame_t *frame)
+{
+	renderBorder(renderer, frame, COLOR_GAME_CHOOSING_LETTERS_BORDER);
+
+	// render title
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_MAIN_TITLE,
+				   "Scegli i tipi delle lettere");
+
+	// render instruction
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_NORMAL,
+				   "Premi:");
+
+	// render keys for choosing types
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_RULE,
+				   "Vocali");
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_RULE,
+				   "Consonanti");
+	if(frame->blanks < frame->maxBlanks) {
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_RULE,
+					   "Jolly");
+	}
+
+	// if the user has choosen at least one char render the generated chars
+	if(strlen(frame->validCharList) > 0) {
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   "Lettere generate:");
+
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_SECONDARY_TITLE,
+					   frame->validCharList);
+	}
+}
+
+void renderRunningState(SDL_Renderer *renderer, const frame_t *frame)
+{
+	// change the border color based on the last word entered
+	switch(frame->lastWordT) {
+
+	case LAST_WORD_NONE: {
+		renderBorder(renderer, frame, COLOR_GAME_RUNNING_NONE_BORDER);
+	} break;
+
+	case LAST_WORD_VALID: {
+		renderBorder(renderer, frame, COLOR_GAME_RUNNING_VALID_BORDER);
+	} break;
+
+	case LAST_WORD_INVALID: {
+		renderBorder(renderer, frame, COLOR_GAME_RUNNING_INVALID_BORDER);
+	} break;
+
+	}
+
+	// render title
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_MAIN_TITLE,
+				   "Crea parole con le lettere date");
+
+	renderTimeLeft(renderer, frame);
+
+	// render available letters
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_NORMAL,
+				   "Lettere disponibili:");
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_SECONDARY_TITLE,
+				   frame->validCharList);
+
+	// render points
+	char phrase[100];
+	if(frame->opponentEnabled) {
+		sprintf(phrase, "Punti: %d - Avversario: %d", frame->points, frame->opponentPoints);
+	} else {
+		sprintf(phrase, "Punti: %d", frame->points);
+	}
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_NORMAL,
+				   phrase);
+
+	// render writing buffer
+	char currentWordS[100];
+	sprintf(currentWordS, " > %s", frame->currentWord);
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_NORMAL,
+				   currentWordS);
+
+	// render the suggestions for the rejected word
+	if(frame->suggestionsNum > 0) {
+		char suggestionsS[100] = "Forse cercavi:";
+		for(size_t i = 0; i < frame->suggestionsNum; i++) {
+			strcat(suggestionsS, i == 0 ? " " : ", ");
+			strcat(suggestionsS, frame->suggestions[i]);
+		}
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   suggestionsS);
+	}
+
+}
+
+void renderEndedState(SDL_Renderer *renderer, const frame_t *frame)
+{
+	renderBorder(renderer, frame, COLOR_GAME_ENDED_BORDER);
+
+	// render points
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_MAIN_TITLE,
+				   "Gioco terminato");
+	char phrase[100];
+	if(frame->opponentEnabled) {
+		sprintf(phrase, "Hai ottenuto %d punti contro %d", frame->points, frame->opponentPoints);
+	} else {
+		sprintf(phrase, "Hai ottenuto %d punti", frame->points);
+	}
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_CENTERED,
+				   phrase);
+
+	// the longest word possible is searched by a job
+	const char *word = frame->longestWord;
+	if(!frame->longestWordReady) {
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   "Ricerca della parola di massima lunghezza...");
+	} else if(strlen(word) == 0) { // if there isn't any, display the fact
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   "Non c'erano parole disponibili");
+	} else { // else show the longest word
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_NORMAL,
+					   "Parola di massima lunghezza possibile:");
+		renderTextType(renderer,
+					   frame,
+					   TEXT_TYPE_SECONDARY_TITLE,
+					   word);
+	}
+
+	// render instruction to exit
+	renderTextType(renderer,
+				   frame,
+				   TEXT_TYPE_BOTTOM,
+				   "Premi [INVIO] per uscire");
+}
+
+void renderGame(SDL_Renderer *renderer, const frame_t *frame)
+{
+	// render the correct state of the game
+	switch(frame->state) {
+
+	case GAME_STATE_LOADING: {
+		renderLoadingState(renderer, frame);
+	} break;
+
+	case GAME_STATE_CHOOSING_LETTERS: {
+		renderChoosingLettersState(renderer, frame);
+	} break;
+
+	case GAME_STATE_RUNNING: {
+		renderRunningState(renderer, frame);
+	} break;
+
+	case GAME_STATE_ENDED: {
+		renderEndedState(renderer, frame);
+	} break;
+
+	default: {
+	} break;
+
+	}
+}
+
+void snapshotGame(const game_t *game, frame_t *frame)
+{
+	frame->assets = &game->assets;
+	frame->state = game->state;
+	frame->screen_width = game->screen_width;
+	frame->screen_height = game->screen_height;
+	frame->timeLeft = game->timeLeft;
+	frame->points = game->points;
+	frame->lastWordT = game->lastWordT;
+	memcpy(frame->suggestions, game->suggestions, sizeof(game->suggestions));
+	frame->suggestionsNum = game->suggestionsNum;
+	memcpy(frame->currentWord, game->currentWord, sizeof(game->currentWord));
+	memcpy(frame->validCharList, game->validCharList, sizeof(game->validCharList));
+	frame->maxBlanks = game->maxBlanks;
+	frame->blanks = game->blanks;
+	frame->multiset = game->multiset;
+	frame->opponentEnabled = game->opponent.enabled;
+	frame->opponentPoints = game->opponent.points;
+	// the longest word is written by a job until it's ready
+	frame->longestWordReady = game->longestWordReady;
+	if(game->longestWordReady) {
+		memcpy(frame->longestWord, game->longestWord, sizeof(game->longestWord));
+	} else {
+		memset(frame->longestWord, 0, sizeof(frame->longestWord));
+	}
+}
+
+void publishFrame(gameThread_t *thread, const game_t *game)
+{
+	// most ticks don't change what is drawn, then there is nothing to draw again
+	frame_t *frame = &thread->frames[thread->back];
+	snapshotGame(game, frame);
+	if(memcmp(frame, &thread->published, sizeof(frame_t)) == 0) {
+		return;
+	}
+	thread->published = *frame;
+
+	// the frame is complete before it can be taken, then the old latest one is the new back
+	SDL_MemoryBarrierRelease();
+	int latest = SDL_AtomicSet(&thread->latest, thread->back | RENDER_FRESH_BIT);
+	thread->back = latest & ~RENDER_FRESH_BIT;
+
+	// wake the main thread, unless the last frame wasn't taken yet and it's already awake for it
+	if(!(latest & RENDER_FRESH_BIT)) {
+		SDL_Event event = {0};
+		event.type = thread->frameEvent;
+		SDL_PushEvent(&event);
+	}
+}
+
+int takeFrame(gameThread_t *thread, int front)
+{
+	// take the latest frame if it's new, the game thread gets the one drawn until now
+	if(SDL_AtomicGet(&thread->latest) & RENDER_FRESH_BIT) {
+		front = SDL_AtomicSet(&thread->latest, front) & ~RENDER_FRESH_BIT;
+		SDL_MemoryBarrierAcquire();
+	}
+	return front;
+}
+
+void pushGameEvent(gameThread_t *thread, const SDL_Event *event)
+{
+	// no event is dropped, if the queue is full wait for the game thread to take one,
+	// unless it has returned after the game was closed
+	while(SDL_SemWaitTimeout(thread->room, LOGIC_TICK_MS) != 0) {
+		if(SDL_AtomicGet(&thread->stopped)) {
+			return;
+		}
+	}
+	SDL_AtomicLock(&thread->eventsLock);
+	thread->events[thread->tail++ % GAME_THREAD_EVENTS] = *event;
+	SDL_AtomicUnlock(&thread->eventsLock);
+	SDL_SemPost(thread->pending);
+}
+
+void popGameEvent(gameThread_t *thread, SDL_Event *event)
+{
+	// called once for every wait on the semaphore, so there is one
+	SDL_AtomicLock(&thread->eventsLock);
+	*event = thread->events[thread->head++ % GAME_THREAD_EVENTS];
+	SDL_AtomicUnlock(&thread->eventsLock);
+	SDL_SemPost(thread->room);
+}
+
+int gameThread(void *data)
+{
+	gameThread_t *thread = data;
+	game_t *game = thread->game;
+
+	SDL_Event event;
+	time_t before, actual;
+	gameState_t reportedState = game->state;
+	reportMemory(GAME_STATE_NAMES[game->state]);
+	Uint32 nextExport = SDL_GetTicks() + METRICS_EXPORT_MS;
+
+	// game cicle, the closed game is published as the last frame
+	while(game->state != GAME_STATE_CLOSE) {
+
+		if(game->state == GAME_STATE_RUNNING) {
+
+			// decrement the time every second
+			actual = time(NULL);
+			game->timeLeft -= (actual-before);
+			before = actual;
+			// if the time has ended, end the game
+			if(game->timeLeft < 1) {
+				game->state = GAME_STATE_ENDED;
+				printOpponentReport(&game->opponent);
+				// the files are synced by a job, the frames go on meanwhile
+				saveRound(game);
+				// search the longest word without blocking the frames
+				initJob(&game->longestWordJob, longestWordJob, longestWordCompleted, game);
+				submitJob(game->jobs, &game->longestWordJob);
+			}
+
+			// play the sound, once the "tic" and once the "tac"
+			if(game->lastTime > game->timeLeft) {
+				if(game->lastTime % 2 == 0) {
+					playSound(game->assets.sounds[AUDIO_TIC]);
+				} else {
+					playSound(game->assets.sounds[AUDIO_TAC]);
+				}
+			}
+
+			game->lastTime = game->timeLeft;
+
+			// let the opponent search and write words in the spare time of the tick
+			stepOpponent(game);
+
+		}
+
+		// wait for the input until the next tick, then repeat for every event read by the main thread
+		bool pending = SDL_SemWaitTimeout(thread->pending, LOGIC_TICK_MS) == 0;
+		for(; pending; pending = SDL_SemTryWait(thread->pending) == 0) {
+			popGameEvent(thread, &event);
+
+			switch(event.type) {
+
+			case SDL_QUIT: {
+				// set state when window is closed
+				game->state = GAME_STATE_CLOSE;
+			} break;
+
+			case SDL_WINDOWEVENT: {
+
+				switch(event.window.event) {
+
+				case SDL_WINDOWEVENT_RESIZED: {
+					// update game window size in case of resize
+					game->screen_width = event.window.data1;
+					game->screen_height = event.window.data2;
+				} break;
+
+				default: {
+				} break;
+
+				}
+
+			} break;
+
+			case SDL_KEYDOWN: {
+
+				switch(game->state) {
+
+				case GAME_STATE_LOADING: {
+					switch(PRESSED_KEY) {
+
+					// if user has pressed enter the game goes to next phase
+					case SDLK_RETURN: {
+						game->state = GAME_STATE_CHOOSING_LETTERS;
+					} break;
+
+					// if the user has pressed q the game exits
+					case SDLK_q: {
+						game->state = GAME_STATE_CLOSE;
+					} break;
+
+					default: {
+					} break;
+
+					}
+				} break;
+
+				case GAME_STATE_CHOOSING_LETTERS: {
+
+					switch(PRESSED_KEY) {
+
+					// 1 and 2 to choose types of letters, 3 for a blank
+					case SDLK_1:
+					case SDLK_2:
+					case SDLK_3: {
+						char ch;
+
+						// generate random char based on the pressed character
+						if(PRESSED_KEY == SDLK_1) {
+							ch = randomVocal();
+						} else if(PRESSED_KEY == SDLK_2) {
+							ch = randomConsonant();
+						} else if(game->blanks < game->maxBlanks) {
+							ch = '?';
+							game->blanks++;
+						} else {
+							break;
+						}
+						// add the generated character to the list
+						game->validCharList[strlen(game->validCharList)] = ch;
+
+						// if the user has selected the type for every letter
+						if(strlen(game->validCharList) == NUM_AVAILABLE_CHARS) {
+							// initialize timer
+							before = time(NULL);
+							game->startTime = before;
+							// the blanks aren't letters of the rack
+							game->rackMask = letterMask(game->validCharList) & ~LETTER_INVALID_BIT;
+							game->rackCounts = letterCounts(game->validCharList);
+							buildWorkingSet(game);
+							startOpponent(game);
+							// pass to next fase
+							game->state = GAME_STATE_RUNNING;
+						}
+
+					} break;
+
+					default: {
+					} break;
+
+					}
+				} break;
+
+				case GAME_STATE_RUNNING: {
+
+					switch(PRESSED_KEY) {
+
+					case SDLK_RETURN: {
+						checkWordAndPlay(game);
+					} break;
+
+					// delete last inserted char if there is any
+					case SDLK_BACKSPACE: {
+						if(game->currentWordSize > 0) {
+							game->currentWord[--game->currentWordSize] = '\0';
+						}
+					} break;
+
+					default: {
+						int ch = PRESSED_KEY;
+						// check if ch is a letter, accented keys type the letter without the accent
+						if(ch >= 0 && ch < 256 && LETTER_OF[ch] != 0) {
+							char letter = LETTER_OF[ch];
+							// verify that the inserted word hasn't reached the max length, leaving space for the terminator
+							if(game->currentWordSize < MAX_WORD_SIZE-1) {
+								// check that the charachter is in the available list, or a blank can stand for it
+								if(canTypeLetter(game, letter)) {
+									// add character to end of word
+									game->currentWord[game->currentWordSize++] = letter;
+								} else {
+									playSound(game->assets.sounds[AUDIO_INCORRECT]);
+								}
+							} else {
+								playSound(game->assets.sounds[AUDIO_INCORRECT]);
+							}
+						}
+					} break;
+
+					}
+
+				} break;
+
+				// close the game if the player presses enter in the final window
+				case GAME_STATE_ENDED: {
+					if(PRESSED_KEY == SDLK_RETURN) {
+						game->state = GAME_STATE_CLOSE;
+					}
+				} break;
+
+				case GAME_STATE_CLOSE: {
+				} break;
+
+				default: {
+				} break;
+
+				}
+			} break;
+
+			default: {
+				// a job of the pool has completed
+				if(event.type == game->jobs->eventType) {
+					completeJob(&event);
+				}
+			} break;
+
+			}
+		}
+
+		// the words added and removed meanwhile
+		pollOverlay(game);
+
+		// the spectators see the changes with the frame
+		publishFeed(game);
+
+		// where the memory goes, at every change of state
+		if(game->state != reportedState) {
+			reportedState = game->state;
+			reportMemory(GAME_STATE_NAMES[game->state]);
+		}
+
+		// the main thread draws this state from the next frame
+		publishFrame(thread, game);
+
+		// periodically write the metrics for the scraper
+		if(game->metricsPath != NULL && SDL_TICKS_PASSED(SDL_GetTicks(), nextExport)) {
+			exportMetrics(game->metricsPath);
+			nextExport = SDL_GetTicks() + METRICS_EXPORT_MS;
+		}
+
+	}
+
+	SDL_AtomicSet(&thread->stopped, 1);
+	return 0;
+}
+
+bool startGameThread(gameThread_t *thread, game_t *game)
+{
+	thread->game = game;
+
+	// every frame starts as the current game, the main thread draws the last one
+	for(size_t i = 0; i < RENDER_FRAMES; i++) {
+		snapshotGame(game, &thread->frames[i]);
+	}
+	thread->published = thread->frames[0];
+	thread->back = 0;
+	SDL_AtomicSet(&thread->latest, 1);
+	thread->frameEvent = SDL_RegisterEvents(1);
+
+	SDL_AtomicSet(&thread->stopped, 0);
+	thread->pending = SDL_CreateSemaphore(0);
+	thread->room = SDL_CreateSemaphore(GAME_THREAD_EVENTS);
+	if(thread->pending == NULL || thread->room == NULL) {
+		fprintf(stderr, "SDL_CreateSemaphore Error: %s\n", SDL_GetError());
+		return false;
+	}
+	thread->thread = SDL_CreateThread(gameThread, "game", thread);
+	if(thread->thread == NULL) {
+		fprintf(stderr, "SDL_CreateThread Error: %s\n", SDL_GetError());
+		SDL_DestroySemaphore(thread->pending);
+		SDL_DestroySemaphore(thread->room);
+		return false;
+	}
+	return true;
+}
+
+int parseSimConfig(simConfig_t *config, int argc, char *argv[])
+{
+	// default configuration, matching the real game
+	config->rounds = SIM_DEFAULT_ROUNDS;
+	config->threads = SDL_GetCPUCount();
+	config->numChars = NUM_AVAILABLE_CHARS;
+	config->vowels = SIM_DEFAULT_VOWELS;
+	config->skill = SIM_DEFAULT_SKILL;
+	config->pace = SIM_DEFAULT_PACE;
+	config->timeMax = TIME_MAX;
+	config->multiset = false;
+	memcpy(config->points, POINTS_BY_LENGTH, sizeof(POINTS_BY_LENGTH));
+	config->numPoints = NUM_POINTS_BY_LENGTH;
+	config->seed = time(NULL);
+
+	// every option takes exactly one value
+	for(int i = 0; i < argc; i += 2) {
+		if(i+1 >= argc) {
+			fprintf(stderr, "Error: missing value for %s\n", argv[i]);
+			return -1;
+		}
+		const char *option = argv[i];
+		const char *value = argv[i+1];
+
+		if(strcmp(option, "--rounds") == 0) {
+			config->rounds = strtoul(value, NULL, 10);
+		} else if(strcmp(option, "--threads") == 0) {
+			config->threads = atoi(value);
+		} else if(strcmp(option, "--letters") == 0) {
+			config->numChars = atoi(value);
+		} else if(strcmp(option, "--vowels") == 0) {
+			config->vowels = atoi(value);
+		} else if(strcmp(option, "--skill") == 0) {
+			config->skill = atoi(value);
+		} else if(strcmp(option, "--pace") == 0) {
+			config->pace = atoi(value);
+		} else if(strcmp(option, "--time") == 0) {
+			config->timeMax = atoi(value);
+		} else if(strcmp(option, "--multiset") == 0) {
+			config->multiset = atoi(value) != 0;
+		} else if(strcmp(option, "--seed") == 0) {
+			config->seed = strtoul(value, NULL, 10);
+		} else if(strcmp(option, "--points") == 0) {
+			// comma separated points, indexed by the word length
+			config->numPoints = 0;
+			char *end;
+			do {
+				config->points[config->numPoints++] = strtol(value, &end, 10);
+				value = end + 1;
+			} while(*end == ',' && config->numPoints <= MAX_WORD_SIZE);
+		} else {
+			fprintf(stderr, "Error: unknown option %s\n", option);
+			return -1;
+		}
+	}
+
+	if(config->threads < 1) {
+		config->threads = 1;
+	}
+	if(config->rounds < 1 || config->rounds > INT32_MAX/2 ||
+	   config->numChars < 1 || config->numChars > MAX_WORD_SIZE || config->vowels < 0 ||
+	   config->vowels > config->numChars ||
+	   config->skill < 0 || config->skill > 100 ||
+	   config->pace < 1 || config->timeMax < 1) {
+		fprintf(stderr, "Error: invalid simulation parameters\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+void simulateRound(const assets_t *assets,
+				   const simConfig_t *config,
+				   Uint32 round,
+				   simStats_t *stats)
+{
+	// every round has its own seed, so the results don't depend on the scheduling
+	Uint32 rng = (config->seed ^ (round * 2654435761u)) | 1;
+	nextRandom(&rng);
+
+	// generate the rack with the requested mix of vowels and consonants
+	char letters[MAX_WORD_SIZE+1];
+	for(int i = 0; i < config->numChars; i++) {
+		if(i < config->vowels) {
+			letters[i] = vocals[nextRandom(&rng)%strlen(vocals)];
+		} else {
+			letters[i] = consonants[nextRandom(&rng)%strlen(consonants)];
+		}
+	}
+	letters[config->numChars] = '\0';
+	Uint32 rack = letterMask(letters);
+	letterCounts_t rackCounts = letterCounts(letters);
+
+	// the bot has time for a limited number of words
+	int maxWords = config->timeMax / config->pace;
+	if(maxWords > MAX_GUESSED_WORDS) {
+		maxWords = MAX_GUESSED_WORDS;
+	}
+
+	// points of the words the bot has written, sampled among the found ones
+	int written[MAX_GUESSED_WORDS];
+	size_t found = 0, solutions = 0;
+
+	for(size_t i = 0; i < assets->numWords; i++) {
+		// skip the words using letters that aren't in the rack, or more copies of them
+		if((assets->wordMasks[i] & ~rack) != 0 ||
+		   (config->multiset && excessLetters(assets->wordCounts[i], rackCounts) != 0)) {
+			continue;
+		}
+		size_t len = strlen(assets->words[i]);
+		if(len < 2) {
+			continue;
+		}
+		solutions++;
+
+		// the bot finds skill% of the solutions, less often the long ones
+		int chance = config->skill;
+		if(len > SIM_SHORT_WORD_SIZE) {
+			chance = chance * SIM_SHORT_WORD_SIZE / len;
+		}
+		if((int)(nextRandom(&rng)%100) >= chance) {
+			continue;
+		}
+
+		// reservoir sampling, so the time limit doesn't favour the first words
+		int points = wordPoints(config->points, config->numPoints, len);
+		if(found < (size_t) maxWords) {
+			written[found] = points;
+		} else {
+			size_t j = nextRandom(&rng) % (found+1);
+			if(j < (size_t) maxWords) {
+				written[j] = points;
+			}
+		}
+		found++;
+	}
+
+	int score = 0;
+	size_t numWritten = found < (size_t) maxWords ? found : (size_t) maxWords;
+	for(size_t i = 0; i < numWritten; i++) {
+		score += written[i];
+	}
+
+	stats->rounds++;
+	stats->solvable += solutions > 0;
+	stats->solutions += solutions;
+	stats->wordsFound += numWritten;
+	stats->scores[score < SIM_MAX_SCORE ? score : SIM_MAX_SCORE]++;
+}
+
+void simulationJob(void *data)
+{
+	simChunk_t *chunk = data;
+	for(Uint32 round = chunk->start; round < chunk->end; round++) {
+		simulateRound(chunk->assets, chunk->config, round, &chunk->stats);
+	}
+}
+
+void mergeSimulationJob(void *data)
+{
+	// merge the statistics of every chunk
+	simMerge_t *merge = data;
+	simStats_t *stats = merge->stats;
+	for(size_t i = 0; i < merge->numChunks; i++) {
+		const simStats_t *chunk = &merge->chunks[i].stats;
+		stats->rounds += chunk->rounds;
+		stats->solvable += chunk->solvable;
+		stats->solutions += chunk->solutions;
+		stats->wordsFound += chunk->wordsFound;
+		for(int score = 0; score <= SIM_MAX_SCORE; score++) {
+			stats->scores[score] += chunk->scores[score];
+		}
+	}
+}
+
+void printSimStats(const simConfig_t *config,
+				   const simStats_t *stats,
+				   double seconds)
+{
+	fprintf(stdout, "Rounds: %zu, threads: %d, time: %.2f s, throughput: %.0f rounds/s\n",
+			stats->rounds, config->threads, seconds, stats->rounds / seconds);
+	fprintf(stdout, "Rack: %d letters, %d vowels; bot: skill %d%%, one word every %d s over %d s\n",
+			config->numChars, config->vowels, config->skill, config->pace, config->timeMax);
+	fprintf(stdout, "Solvable racks: %.2f%%, solutions per rack: %.1f, words per round: %.1f\n",
+			100.0 * stats->solvable / stats->rounds,
+			(double) stats->solutions / stats->rounds,
+			(double) stats->wordsFound / stats->rounds);
+
+	// mean and percentiles of the score, from the histogram
+	const int percentiles[] = {10, 50, 90, 99};
+	size_t numPercentiles = sizeof(percentiles)/sizeof(int);
+	size_t p = 0, count = 0;
+	double total = 0;
+	int max = 0;
+	fprintf(stdout, "Score:");
+	for(int score = 0; score <= SIM_MAX_SCORE; score++) {
+		total += (double) score * stats->scores[score];
+		count += stats->scores[score];
+		while(p < numPercentiles && count * 100 >= stats->rounds * percentiles[p]) {
+			fprintf(stdout, " p%d %d,", percentiles[p], score);
+			p++;
+		}
+		if(stats->scores[score] > 0) {
+			max = score;
+		}
+	}
+	fprintf(stdout, " max %d, mean %.2f\n", max, total / stats->rounds);
+
+	// score distribution, one line for every bucket
+	for(int bucket = 0; bucket <= max; bucket += SIM_HISTOGRAM_BUCKET) {
+		size_t num = 0;
+		for(int score = bucket; score < bucket + SIM_HISTOGRAM_BUCKET && score <= SIM_MAX_SCORE; score++) {
+			num += stats->scores[score];
+		}
+		double percent = 100.0 * num / stats->rounds;
+		fprintf(stdout, "%4d-%-4d %6.2f%% ", bucket, bucket + SIM_HISTOGRAM_BUCKET - 1, percent);
+		for(int i = 0; i < (int) (percent / 2 + 0.5); i++) {
+			fputc('#', stdout);
+		}
+		fputc('\n', stdout);
+	}
+}
+
+int runSimulation(int argc, char *argv[])
+{
+	simConfig_t config;
+	if(parseSimConfig(&config, argc, argv) != 0) {
+		fprintf(stderr, "Usage: main --simulate [--rounds N] [--threads N] [--letters N] [--vowels N]\n"
+				"                       [--skill PERCENT] [--pace SECONDS] [--time SECONDS]\n"
+				"                       [--multiset 0|1] [--points P0,P1,...] [--seed N]\n");
+		return EXIT_FAILURE;
+	}
+
+	// the dictionary is too big for the stack
+	assets_t *assets = calloc(1, sizeof(assets_t));
+	jobPool_t *jobs = createJobPool(config.threads);
+	config.threads = jobs->numWorkers;
+
+	// many small chunks, so the workers that finish early steal from the others
+	size_t numChunks = config.threads * SIM_CHUNKS_PER_THREAD;
+	if(numChunks > config.rounds / SIM_ROUNDS_PER_CHUNK) {
+		numChunks = config.rounds / SIM_ROUNDS_PER_CHUNK;
+	}
+	if(numChunks < 1) {
+		numChunks = 1;
+	}
+	simChunk_t *chunks = calloc(numChunks, sizeof(simChunk_t));
+	simStats_t *stats = calloc(1, sizeof(simStats_t));
+	if(assets == NULL || chunks == NULL || stats == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the simulation\n");
+		return EXIT_FAILURE;
+	}
+	loadDictionary(assets, jobs);
+
+	// the words in both lists are played once, like in the game,
+	// the later copies are marked invalid so they never match a rack
+	if(assets->overlay.table == NULL) {
+		buildWordTable(assets);
+	}
+	for(size_t i = 0; i < assets->numWords; i++) {
+		if(findDictionaryWord(assets, assets->words[i]) != (Sint32) i) {
+			assets->wordMasks[i] |= LETTER_INVALID_BIT;
+		}
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	// the statistics are merged by a job that depends on every chunk
+	simMerge_t merge = {.chunks = chunks, .numChunks = numChunks, .stats = stats};
+	initJob(&merge.job, mergeSimulationJob, NULL, &merge);
+	for(size_t i = 0; i < numChunks; i++) {
+		chunks[i].assets = assets;
+		chunks[i].config = &config;
+		chunks[i].start = config.rounds * i / numChunks;
+		chunks[i].end = config.rounds * (i+1) / numChunks;
+		initJob(&chunks[i].job, simulationJob, NULL, &chunks[i]);
+		addJobDependency(jobs, &merge.job, &chunks[i].job);
+		submitJob(jobs, &chunks[i].job);
+	}
+	submitJob(jobs, &merge.job);
+	waitJob(jobs, &merge.job);
+
+	double seconds = (double) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+	printSimStats(&config, stats, seconds);
+
+	free(stats);
+	free(chunks);
+	freeDictionary(assets);
+	free(assets);
+	destroyJobPool(jobs);
+
+	return EXIT_SUCCESS;
+}
+
+bool writeAll(int fd, const void *data, size_t size)
+{
+	const char *bytes = data;
+	// write can be partial, repeat until everything is written
+	while(size > 0) {
+		ssize_t written = write(fd, bytes, size);
+		if(written < 0) {
+			return false;
+		}
+		bytes += written;
+		size -= written;
+	}
+	return true;
+}
+
+bool replaceFile(const char *path, const char *data, size_t size, const char *more, size_t moreSize)
+{
+	// written next to the file and renamed over it, the readers see the old or the new file
+	char temp[100];
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(fd < 0) {
+		return false;
+	}
+	bool ok = writeAll(fd, data, size) && writeAll(fd, more, moreSize) && fsync(fd) == 0;
+	ok = close(fd) == 0 && ok;
+	return ok && rename(temp, path) == 0;
+}
+
+void saveRound(game_t *game)
+{
+	const assets_t *assets = &game->assets;
+	historyRound_t *round = &game->savedRound;
+
+	// the previous round is still being written, the rounds are appended in order
+	if(round->job.run != NULL) {
+		waitJob(game->jobs, &round->job);
+	}
+
+	// collect the words of the rack the player didn't find
+	const workingSet_t *set = &game->workingSet;
+	Uint32 *missed = malloc(sizeof(Uint32) * (set->num+1));
+	if(missed == NULL) {
+		fprintf(stderr, "Error: couldn't save the round\n");
+		return;
+	}
+	size_t missedNum = 0;
+	for(size_t k = 0; k < set->num; k++) {
+		Uint32 i = set->ids[k];
+		if(strlen(assets->words[i]) < 2) {
+			continue;
+		}
+		// the same word may be in both lists, only the first one is found
+		bool skip = findRackWord(game, assets->words[i]) != (Sint32) i;
+		for(size_t j = 0; j < game->guessedWordsNum && !skip; j++) {
+			skip = game->guessedIds[j] == i;
+		}
+		if(!skip) {
+			missed[missedNum++] = i;
+		}
+	}
+
+	memcpy(round->rack, game->validCharList, NUM_AVAILABLE_CHARS);
+	round->score = game->points;
+	round->startTime = game->startTime;
+	round->guessedNum = game->guessedWordsNum;
+	memcpy(round->guessedIds, game->guessedIds, sizeof(Uint32) * game->guessedWordsNum);
+	memcpy(round->guessedAt, game->guessedAt, sizeof(Uint16) * game->guessedWordsNum);
+	round->missed = missed;
+	round->missedNum = missedNum;
+	initJob(&round->job, saveRoundJob, NULL, round);
+	submitJob(game->jobs, &round->job);
+}
+
+void saveRoundJob(void *data)
+{
+	historyRound_t *round = data;
+	Uint32 *missed = round->missed;
+	size_t missedNum = round->missedNum;
+
+	mkdir(HISTORY_DIR, 0755);
+
+	// number of rounds completely written, the data after them is discarded
+	Uint64 rounds = 0;
+	FILE *fp = fopen(HISTORY_DIR "rounds.cnt", "rb");
+	if(fp != NULL) {
+		if(fread(&rounds, sizeof(rounds), 1, fp) != 1) {
+			rounds = 0;
+		}
+		fclose(fp);
+	}
+
+	int fds[NUM_HISTORY_COLUMNS];
+	bool ok = true;
+	for(size_t i = 0; i < NUM_HISTORY_COLUMNS; i++) {
+		char path[100] = HISTORY_DIR;
+		strcat(path, HISTORY_FILES[i]);
+		fds[i] = open(path, O_RDWR | O_CREAT, 0644);
+		ok = ok && fds[i] >= 0;
+	}
+
+	// find where the variable columns end
+	Uint32 guessedEnd = 0, missedEnd = 0;
+	if(ok && rounds > 0) {
+		off_t last = (rounds-1) * sizeof(Uint32);
+		ok = pread(fds[HISTORY_GUESSED_END], &guessedEnd, sizeof(Uint32), last) == sizeof(Uint32) &&
+			 pread(fds[HISTORY_MISSED_END], &missedEnd, sizeof(Uint32), last) == sizeof(Uint32);
+	}
+
+	// truncate the columns to the last complete round
+	for(size_t i = 0; ok && i < NUM_HISTORY_COLUMNS; i++) {
+		off_t size = rounds;
+		if(i == HISTORY_GUESSED || i == HISTORY_GUESSED_AT) {
+			size = guessedEnd;
+		} else if(i == HISTORY_MISSED) {
+			size = missedEnd;
+		}
+		ok = ftruncate(fds[i], size * HISTORY_SIZES[i]) == 0 &&
+			 lseek(fds[i], 0, SEEK_END) >= 0;
+	}
+
+	// append the round to every column
+	guessedEnd += round->guessedNum;
+	missedEnd += missedNum;
+	ok = ok &&
+		 writeAll(fds[HISTORY_RACK], round->rack, NUM_AVAILABLE_CHARS) &&
+		 writeAll(fds[HISTORY_SCORE], &round->score, sizeof(round->score)) &&
+		 writeAll(fds[HISTORY_TIME], &round->startTime, sizeof(round->startTime)) &&
+		 writeAll(fds[HISTORY_GUESSED_END], &guessedEnd, sizeof(guessedEnd)) &&
+		 writeAll(fds[HISTORY_GUESSED], round->guessedIds, sizeof(Uint32) * round->guessedNum) &&
+		 writeAll(fds[HISTORY_GUESSED_AT], round->guessedAt, sizeof(Uint16) * round->guessedNum) &&
+		 writeAll(fds[HISTORY_MISSED_END], &missedEnd, sizeof(missedEnd)) &&
+		 writeAll(fds[HISTORY_MISSED], missed, sizeof(Uint32) * missedNum);
+
+	for(size_t i = 0; i < NUM_HISTORY_COLUMNS; i++) {
+		if(fds[i] >= 0) {
+			ok = fsync(fds[i]) == 0 && ok;
+			close(fds[i]);
+		}
+	}
+	free(missed);
+	round->missed = NULL;
+
+	// commit the round only once all the columns are on disk
+	rounds++;
+	fp = ok ? fopen(HISTORY_DIR "rounds.tmp", "wb") : NULL;
+	if(fp != NULL) {
+		ok = fwrite(&rounds, sizeof(rounds), 1, fp) == 1;
+		ok = fflush(fp) == 0 && fsync(fileno(fp)) == 0 && ok;
+		fclose(fp);
+		ok = ok && rename(HISTORY_DIR "rounds.tmp", HISTORY_DIR "rounds.cnt") == 0;
+	}
+	if(!ok || fp == NULL) {
+		fprintf(stderr, "Error: couldn't save the round in %s\n", HISTORY_DIR);
+		return;
+	}
+	fprintf(stdout, "Round %llu saved.\n", (unsigned long long) rounds);
+}
+
+void *mapHistoryColumn(historyColumns_t column, size_t *size)
+{
+	char path[100] = HISTORY_DIR;
+	strcat(path, HISTORY_FILES[column]);
+
+	*size = 0;
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	void *data = NULL;
+	if(fstat(fd, &info) == 0 && info.st_size > 0) {
+		data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED) {
+			data = NULL;
+		} else {
+			*size = info.st_size;
+		}
+	}
+	// the mapping stays valid after closing the file
+	close(fd);
+	return data;
+}
+
+void unmapHistory(void *columns[NUM_HISTORY_COLUMNS], const size_t sizes[NUM_HISTORY_COLUMNS])
+{
+	for(size_t i = 0; i < NUM_HISTORY_COLUMNS; i++) {
+		if(columns[i] != NULL) {
+			munmap(columns[i], sizes[i]);
+		}
+	}
 }
 
+int compareRackAverage(const void *a, const void *b)
+{
+	const historyRack_t *rackA = a, *rackB = b;
+	// sort by decreasing average, comparing total_a/count_a with total_b/count_b
+	Sint64 lhs = rackA->total * rackB->count, rhs = rackB->total * rackA->count;
+	if(lhs != rhs) {
+		return lhs > rhs ? -1 : 1;
+	}
+	return (int) rackB->count - (int) rackA->count;
+}
 
-void renderLoadingState(SDL_Renderer *renderer, const game_t *game)
+int runHistoryQuery(int argc, char *argv[])
 {
-	renderBorder(renderer, game, COLOR_GAME_LOADING_BORDER);
+	if(argc < 1 ||
+	   (strcmp(argv[0], "top") != 0 && strcmp(argv[0], "racks") != 0 && strcmp(argv[0], "missed") != 0)) {
+		fprintf(stderr, "Usage: main --history top|racks|missed [K]\n");
+		return EXIT_FAILURE;
+	}
+	size_t k = HISTORY_DEFAULT_TOP;
+	if(argc > 1) {
+		char *end;
+		long value = strtol(argv[1], &end, 10);
+		if(end == argv[1] || *end != '\0' || value < 1) {
+			fprintf(stderr, "Error: K must be a positive number\n");
+			return EXIT_FAILURE;
+		}
+		// it's capped below by the rows there are, so it can't size a huge allocation
+		k = value;
+	}
 
-	// render welcome message
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_MAIN_TITLE,
-				   "Benvenuto a Paroliere");
+	// only the committed rounds are read
+	Uint64 rounds = 0;
+	FILE *fp = fopen(HISTORY_DIR "rounds.cnt", "rb");
+	if(fp != NULL) {
+		if(fread(&rounds, sizeof(rounds), 1, fp) != 1) {
+			rounds = 0;
+		}
+		fclose(fp);
+	}
 
-	// render rule title
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_NORMAL,
-				   "Regole:");
+	void *columns[NUM_HISTORY_COLUMNS];
+	size_t sizes[NUM_HISTORY_COLUMNS];
+	for(size_t i = 0; i < NUM_HISTORY_COLUMNS; i++) {
+		columns[i] = mapHistoryColumn(i, &sizes[i]);
+		if(sizes[i] < rounds * HISTORY_SIZES[i] && i != HISTORY_GUESSED &&
+		   i != HISTORY_GUESSED_AT && i != HISTORY_MISSED) {
+			rounds = 0;
+		}
+	}
+	if(rounds == 0) {
+		fprintf(stdout, "No rounds played yet.\n");
+		unmapHistory(columns, sizes);
+		return EXIT_SUCCESS;
+	}
 
-	// rule list
-	const char *rules[] = {
-		"- Scegli 10 tra vocali e consonanti;",
-		"- Devi formare parole con le lettere generate;",
-		"- Puoi utilizzare le lettere varie volte;",
-		"- Hai 120 secondi.",
-	};
-	// calculating number of rules
-	size_t numRules = sizeof(rules)/sizeof(char*);
-	// renderering every rule
-	for(size_t i=0;i<numRules;i++) {
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_NORMAL,
-					   rules[i]);
+	const char *racks = columns[HISTORY_RACK];
+	const Sint32 *scores = columns[HISTORY_SCORE];
+	const Sint64 *times = columns[HISTORY_TIME];
+
+	if(strcmp(argv[0], "top") == 0) {
+		// keep the k best rounds sorted, most rounds are discarded by the first comparison
+		k = k < rounds ? k : rounds;
+		size_t *best = malloc(sizeof(size_t) * k);
+		if(best == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the best rounds\n");
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+		size_t num = 0;
+		for(size_t row = 0; row < rounds; row++) {
+			if(num == k && scores[row] <= scores[best[k-1]]) {
+				continue;
+			}
+			size_t pos = num < k ? num++ : k-1;
+			while(pos > 0 && scores[best[pos-1]] < scores[row]) {
+				best[pos] = best[pos-1];
+				pos--;
+			}
+			best[pos] = row;
+		}
+
+		for(size_t i = 0; i < num; i++) {
+			char date[20];
+			time_t start = times[best[i]];
+			strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&start));
+			fprintf(stdout, "%2zu) %4d punti  %.*s  %s\n", i+1, scores[best[i]],
+					NUM_AVAILABLE_CHARS, racks + best[i] * NUM_AVAILABLE_CHARS, date);
+		}
+		free(best);
+	} else if(strcmp(argv[0], "racks") == 0) {
+		// group the rounds by rack, ignoring the order of the letters
+		size_t capacity = 1;
+		while(capacity < rounds * 2) {
+			capacity *= 2;
+		}
+		historyRack_t *table = calloc(capacity, sizeof(historyRack_t));
+		if(table == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the racks\n");
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+		size_t num = 0;
+		for(size_t row = 0; row < rounds; row++) {
+			char rack[NUM_AVAILABLE_CHARS+1] = {0};
+			memcpy(rack, racks + row * NUM_AVAILABLE_CHARS, NUM_AVAILABLE_CHARS);
+			for(size_t i = 1; i < NUM_AVAILABLE_CHARS; i++) {
+				for(size_t j = i; j > 0 && rack[j-1] > rack[j]; j--) {
+					char tmp = rack[j];
+					rack[j] = rack[j-1];
+					rack[j-1] = tmp;
+				}
+			}
+
+			// open addressing with linear probing
+			Uint32 hash = 2166136261u;
+			for(size_t i = 0; i < NUM_AVAILABLE_CHARS; i++) {
+				hash = (hash ^ (Uint8) rack[i]) * 16777619u;
+			}
+			size_t slot = hash & (capacity-1);
+			while(table[slot].count > 0 && strcmp(table[slot].rack, rack) != 0) {
+				slot = (slot+1) & (capacity-1);
+			}
+			if(table[slot].count == 0) {
+				strcpy(table[slot].rack, rack);
+				num++;
+			}
+			table[slot].count++;
+			table[slot].total += scores[row];
+		}
+
+		// move the used entries at the start of the table and sort them
+		size_t used = 0;
+		for(size_t slot = 0; slot < capacity; slot++) {
+			if(table[slot].count > 0) {
+				table[used++] = table[slot];
+			}
+		}
+		qsort(table, num, sizeof(historyRack_t), compareRackAverage);
+		for(size_t i = 0; i < num && i < k; i++) {
+			fprintf(stdout, "%s  %6.2f punti di media in %u partite\n", table[i].rack,
+					(double) table[i].total / table[i].count, table[i].count);
+		}
+		free(table);
+	} else {
+		const Uint32 *missedEnd = columns[HISTORY_MISSED_END];
+		const Uint32 *missed = columns[HISTORY_MISSED];
+		size_t numMissed = missedEnd[rounds-1];
+		if(sizes[HISTORY_MISSED] < numMissed * sizeof(Uint32)) {
+			fprintf(stderr, "Error: the history is corrupted\n");
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+
+		// the ids refer to the dictionary, needed to print the words
+		assets_t *assets = calloc(1, sizeof(assets_t));
+		if(assets == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+		// with the user words there can be more than MAX_WORDS
+		loadDictionary(assets, NULL);
+		Uint32 *counts = calloc(assets->numWords, sizeof(Uint32));
+		if(counts == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+			freeDictionary(assets);
+			free(assets);
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+		for(size_t i = 0; i < numMissed; i++) {
+			if(missed[i] < assets->numWords) {
+				counts[missed[i]]++;
+			}
+		}
+
+		// select the k most missed words
+		k = k < assets->numWords ? k : assets->numWords;
+		size_t *worst = malloc(sizeof(size_t) * k);
+		if(worst == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the missed words\n");
+			free(counts);
+			freeDictionary(assets);
+			free(assets);
+			unmapHistory(columns, sizes);
+			return EXIT_FAILURE;
+		}
+		size_t num = 0;
+		for(size_t id = 0; id < assets->numWords; id++) {
+			if(counts[id] == 0 || (num == k && counts[id] <= counts[worst[k-1]])) {
+				continue;
+			}
+			size_t pos = num < k ? num++ : k-1;
+			while(pos > 0 && counts[worst[pos-1]] < counts[id]) {
+				worst[pos] = worst[pos-1];
+				pos--;
+			}
+			worst[pos] = id;
+		}
+		for(size_t i = 0; i < num; i++) {
+			fprintf(stdout, "%-20s mancata in %u partite su %llu\n", wordText(assets, worst[i]),
+					counts[worst[i]], (unsigned long long) rounds);
+		}
+		free(worst);
+		free(counts);
+		freeDictionary(assets);
+		free(assets);
 	}
 
-	// render instruction for next game state and exit
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_BOTTOM,
-				   "Premi [INVIO] per continuare, [Q] per uscire");
+	unmapHistory(columns, sizes);
+	return EXIT_SUCCESS;
+}
 
+void setupBenchGame(game_t *game, gameState_t state)
+{
+	// a typical frame of every state
+	game->state = state;
+	game->timeLeft = TIME_MAX/2;
+	game->points = 42;
+	game->lastWordT = LAST_WORD_INVALID;
+	strcpy(game->validCharList, state == GAME_STATE_CHOOSING_LETTERS ? "AEOST" : "AEIOSTRLNC");
+	game->rackMask = letterMask(game->validCharList);
+	game->rackCounts = letterCounts(game->validCharList);
+	buildWorkingSet(game);
+	strcpy(game->currentWord, "CANTIERE");
+	game->currentWordSize = strlen(game->currentWord);
+	game->suggestionsNum = 0;
+	findSuggestions(game, "CANTEO");
+	findValidWord(game, game->longestWord);
+	game->longestWordReady = true;
 }
 
-void renderChoosingLettersState(SDL_Renderer *renderer, const game_t *game)
+int runRenderBenchmark(int argc, char *argv[])
 {
-	renderBorder(renderer, game, COLOR_GAME_CHOOSING_LETTERS_BORDER);
+	int frames = argc > 0 ? atoi(argv[0]) : BENCH_DEFAULT_FRAMES;
+	if(frames < 1) {
+		fprintf(stderr, "Usage: main --bench-render [FRAMES]\n");
+		return EXIT_FAILURE;
+	}
 
-	// render title
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_MAIN_TITLE,
-				   "Scegli i tipi delle lettere");
+	// no window and no sound card are needed
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	if(initLibraries() != 0) {
+		return EXIT_FAILURE;
+	}
 
-	// render instruction
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_NORMAL,
-				   "Premi:");
+	game_t *game = calloc(1, sizeof(game_t));
+	if(game == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the game\n");
+		return EXIT_FAILURE;
+	}
+	game->screen_width = SCREEN_DEFAULT_WIDTH;
+	game->screen_height = SCREEN_DEFAULT_HEIGHT;
+	game->jobs = createJobPool(SDL_GetCPUCount());
+	loadAssets(&game->assets, game->jobs);
+
+	// render in memory with the software renderer, never waiting for vsync
+	SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, game->screen_width, game->screen_height,
+														 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer *renderer = target != NULL ? SDL_CreateSoftwareRenderer(target) : NULL;
+	if(renderer == NULL) {
+		fprintf(stderr, "SDL_CreateSoftwareRenderer Error: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	uploadFontAtlas(&game->assets, renderer);
+
+	const char *names[] = {"loading", "choosing letters", "running", "ended"};
+	const gameState_t states[] = {
+		GAME_STATE_LOADING,
+		GAME_STATE_CHOOSING_LETTERS,
+		GAME_STATE_RUNNING,
+		GAME_STATE_ENDED
+	};
+	size_t numStates = sizeof(states)/sizeof(gameState_t);
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 total = 0;
+
+	fprintf(stdout, "Rendering %d frames per state at %dx%d with the software renderer\n",
+			frames, game->screen_width, game->screen_height);
+	for(size_t i = 0; i < numStates; i++) {
+		setupBenchGame(game, states[i]);
+		// drawn from a snapshot, like the frames of the game
+		frame_t snapshot;
+		snapshotGame(game, &snapshot);
+		Uint64 stateTotal = 0, max = 0;
+
+		for(int frame = -BENCH_WARMUP_FRAMES; frame < frames; frame++) {
+			Uint64 start = SDL_GetPerformanceCounter();
+			SDL_RenderClear(renderer);
+			renderGame(renderer, &snapshot);
+			SDL_RenderPresent(renderer);
+			Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+
+			// the first frames only warm up the caches
+			if(frame >= 0) {
+				stateTotal += elapsed;
+				if(elapsed > max) {
+					max = elapsed;
+				}
+			}
+		}
 
-	// render keys for choosing types
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_RULE,
-				   "Vocali");
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_RULE,
-				   "Consonanti");
+		total += stateTotal;
+		double mean = (double) stateTotal / frames / frequency;
+		fprintf(stdout, "%-18s %9.1f fps %8.3f ms/frame, max %8.3f ms\n", names[i],
+				1 / mean, mean * 1000, (double) max * 1000 / frequency);
+	}
+	fprintf(stdout, "%-18s %9.1f fps\n", "all states",
+			(double) frames * numStates * frequency / total);
 
-	// if the user has choosen at least one char render the generated chars
-	if(strlen(game->validCharList) > 0) {
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_NORMAL,
-					   "Lettere generate:");
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(target);
+	freeAudio(game->assets.sounds);
+	destroyJobPool(game->jobs);
+	freeMemory(MEMORY_WORKING_SET, game->workingSet.ids);
+	freeMemory(MEMORY_WORKING_SET, game->workingSet.table);
+	freeDictionary(&game->assets);
+	free(game);
+	TTF_Quit();
+	Mix_CloseAudio();
+	SDL_Quit();
 
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_SECONDARY_TITLE,
-					   game->validCharList);
-	}
+	return EXIT_SUCCESS;
 }
 
-void renderRunningState(SDL_Renderer *renderer, const game_t *game)
+int runJobsBenchmark(void)
 {
-	// change the border color based on the last word entered
-	switch(game->lastWordT) {
+	assets_t *assets = calloc(1, sizeof(assets_t));
+	if(assets == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+		return EXIT_FAILURE;
+	}
+	loadDictionary(assets, NULL);
+
+	simConfig_t config;
+	parseSimConfig(&config, 0, NULL);
+	config.rounds = BENCH_ROUNDS;
+	size_t numChunks = BENCH_ROUNDS / SIM_ROUNDS_PER_CHUNK;
+	simChunk_t *chunks = calloc(numChunks, sizeof(simChunk_t));
+	if(chunks == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the simulation\n");
+		return EXIT_FAILURE;
+	}
 
-	case LAST_WORD_NONE: {
-		renderBorder(renderer, game, COLOR_GAME_RUNNING_NONE_BORDER);
-	} break;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	double baseIndex = 0, baseSolve = 0;
+	int cores = SDL_GetCPUCount();
 
-	case LAST_WORD_VALID: {
-		renderBorder(renderer, game, COLOR_GAME_RUNNING_VALID_BORDER);
-	} break;
+	fprintf(stdout, "Indexing %zu words %d times, solving %d racks, %d cores\n",
+			assets->numWords, BENCH_INDEX_REPEAT, BENCH_ROUNDS, cores);
+	fprintf(stdout, "threads   index ms  speedup   solve ms  speedup\n");
+	for(int threads = 1; threads <= cores; threads = threads < cores && threads*2 > cores ? cores : threads*2) {
+		jobPool_t *jobs = createJobPool(threads);
 
-	case LAST_WORD_INVALID: {
-		renderBorder(renderer, game, COLOR_GAME_RUNNING_INVALID_BORDER);
-	} break;
+		// dictionary indexing
+		Uint64 start = SDL_GetPerformanceCounter();
+		for(int i = 0; i < BENCH_INDEX_REPEAT; i++) {
+			indexDictionary(assets, jobs);
+		}
+		double index = (double) (SDL_GetPerformanceCounter() - start) * 1000 / frequency / BENCH_INDEX_REPEAT;
+
+		// rack solving, as simulated rounds
+		start = SDL_GetPerformanceCounter();
+		for(size_t i = 0; i < numChunks; i++) {
+			memset(&chunks[i].stats, 0, sizeof(simStats_t));
+			chunks[i].assets = assets;
+			chunks[i].config = &config;
+			chunks[i].start = i * SIM_ROUNDS_PER_CHUNK;
+			chunks[i].end = (i+1) * SIM_ROUNDS_PER_CHUNK;
+			initJob(&chunks[i].job, simulationJob, NULL, &chunks[i]);
+			submitJob(jobs, &chunks[i].job);
+		}
+		for(size_t i = 0; i < numChunks; i++) {
+			waitJob(jobs, &chunks[i].job);
+		}
+		double solve = (double) (SDL_GetPerformanceCounter() - start) * 1000 / frequency;
+
+		if(threads == 1) {
+			baseIndex = index;
+			baseSolve = solve;
+		}
+		fprintf(stdout, "%7d %10.3f %7.2fx %10.1f %7.2fx\n",
+				threads, index, baseIndex / index, solve, baseSolve / solve);
+		destroyJobPool(jobs);
 
+		if(threads == cores) {
+			break;
+		}
 	}
 
-	// render title
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_MAIN_TITLE,
-				   "Crea parole con le lettere date");
+	free(chunks);
+	freeDictionary(assets);
+	free(assets);
+	return EXIT_SUCCESS;
+}
 
-	renderTimeLeft(renderer, game);
+void sortLetters(const char *word, char *signature)
+{
+	// insertion sort, the words are short
+	size_t len = 0;
+	for(; word[len] != '\0'; len++) {
+		size_t pos = len;
+		while(pos > 0 && signature[pos-1] > word[len]) {
+			signature[pos] = signature[pos-1];
+			pos--;
+		}
+		signature[pos] = word[len];
+	}
+	signature[len] = '\0';
+}
 
-	// render available letters
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_NORMAL,
-				   "Lettere disponibili:");
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_SECONDARY_TITLE,
-				   game->validCharList);
+int compareSignatures(const void *a, const void *b)
+{
+	const signature_t *x = a, *y = b;
+	int order = strcmp(x->signature, y->signature);
+	if(order != 0) {
+		return order;
+	}
+	return (x->id > y->id) - (x->id < y->id);
+}
 
-	// render points
-	char phrase[100];
-	sprintf(phrase, "Punti: %d", game->points);
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_NORMAL,
-				   phrase);
+int compareIds(const void *a, const void *b)
+{
+	Uint32 x = *(const Uint32 *) a, y = *(const Uint32 *) b;
+	return (x > y) - (x < y);
+}
 
-	// render writing buffer
-	char currentWordS[100];
-	sprintf(currentWordS, " > %s", game->currentWord);
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_NORMAL,
-				   currentWordS);
+Uint32 addTrieChild(queryIndex_t *index, Uint32 node, char letter)
+{
+	// look for the letter among the children, keeping them sorted
+	Uint32 prev = 0;
+	Uint32 child = index->nodes[node].child;
+	while(child != 0 && index->nodes[child].letter < letter) {
+		prev = child;
+		child = index->nodes[child].sibling;
+	}
+	if(child != 0 && index->nodes[child].letter == letter) {
+		return child;
+	}
 
+	if(index->numNodes == index->nodesCapacity) {
+		index->nodesCapacity *= 2;
+		index->nodes = realloc(index->nodes, sizeof(trieNode_t) * index->nodesCapacity);
+		if(index->nodes == NULL) {
+			fprintf(stderr, "Error: couldn't allocate the trie\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	Uint32 added = index->numNodes++;
+	index->nodes[added] = (trieNode_t) {.letter = letter, .sibling = child};
+	if(prev == 0) {
+		index->nodes[node].child = added;
+	} else {
+		index->nodes[prev].sibling = added;
+	}
+	return added;
 }
 
-void renderEndedState(SDL_Renderer *renderer, const game_t *game)
+void buildQueryIndex(queryIndex_t *index, const assets_t *assets)
 {
-	renderBorder(renderer, game, COLOR_GAME_ENDED_BORDER);
+	index->assets = assets;
+	index->signatures = malloc(sizeof(signature_t) * assets->numWords);
+	index->results = malloc(sizeof(Uint32) * assets->numWords);
+	// the root and roughly two nodes per word
+	index->nodesCapacity = 2 * assets->numWords + 1;
+	index->nodes = malloc(sizeof(trieNode_t) * index->nodesCapacity);
+	if(index->signatures == NULL || index->results == NULL || index->nodes == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the query index\n");
+		exit(EXIT_FAILURE);
+	}
+	index->nodes[0] = (trieNode_t) {0};
+	index->numNodes = 1;
+	index->query = 0;
+
+	index->numSignatures = 0;
+	for(size_t i = 0; i < assets->numWords; i++) {
+		// the words removed by the user aren't found
+		if((assets->wordMasks[i] & LETTER_REMOVED_BIT) != 0) {
+			continue;
+		}
+		signature_t *signature = &index->signatures[index->numSignatures++];
+		sortLetters(assets->words[i], signature->signature);
+		signature->id = i;
 
-	// render points
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_MAIN_TITLE,
-				   "Gioco terminato");
-	char phrase[100];
-	sprintf(phrase, "Hai ottenuto %d punti", game->points);
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_CENTERED,
-				   phrase);
+		Uint32 node = 0;
+		for(size_t j = 0; assets->words[i][j] != '\0'; j++) {
+			node = addTrieChild(index, node, assets->words[i][j]);
+		}
+		// the words in both lists are kept once
+		if(node != 0 && index->nodes[node].word == 0) {
+			index->nodes[node].word = i + 1;
+		}
+	}
+	qsort(index->signatures, index->numSignatures, sizeof(signature_t), compareSignatures);
+}
 
-	// find longest word possible
-	char word[MAX_WORD_SIZE]="";
-	findValidWord(game, word);
-	// if there isn't any, display the fact
-	if(strlen(word) == 0) {
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_NORMAL,
-					   "Non c'erano parole disponibili");
-	} else { // else show the longest word
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_NORMAL,
-					   "Parola di massima lunghezza possibile:");
-		renderTextType(renderer,
-					   game,
-					   TEXT_TYPE_SECONDARY_TITLE,
-					   word);
+void findAnagrams(queryIndex_t *index, const char *letters)
+{
+	char signature[QUERY_MAX_SIZE];
+	sortLetters(letters, signature);
+
+	// first word with the same signature
+	size_t low = 0, high = index->numSignatures;
+	while(low < high) {
+		size_t mid = low + (high - low) / 2;
+		if(strcmp(index->signatures[mid].signature, signature) < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
 	}
 
-	// render instruction to exit
-	renderTextType(renderer,
-				   game,
-				   TEXT_TYPE_BOTTOM,
-				   "Premi [INVIO] per uscire");
+	for(size_t i = low; i < index->numSignatures && strcmp(index->signatures[i].signature, signature) == 0; i++) {
+		Uint32 id = index->signatures[i].id;
+		// the words in both lists are kept once
+		bool duplicate = false;
+		for(size_t j = 0; j < index->numResults && !duplicate; j++) {
+			duplicate = strcmp(index->assets->words[index->results[j]], index->assets->words[id]) == 0;
+		}
+		if(!duplicate) {
+			index->results[index->numResults++] = id;
+		}
+	}
 }
 
-void renderGame(SDL_Renderer *renderer, const game_t *game)
+void matchPattern(queryIndex_t *index, Uint32 node, const char *pattern)
 {
-	// render the correct state of the game
-	switch(game->state) {
+	trieNode_t *nodes = index->nodes;
+
+	// the rest of the pattern from the same node gives the same words again,
+	// the offsets of a node are cleared the first time the query walks it
+	Uint8 *offsets = index->visited + node * index->offsetBytes;
+	if(nodes[node].walked != index->query) {
+		nodes[node].walked = index->query;
+		memset(offsets, 0, index->offsetBytes);
+	}
+	size_t offset = pattern - index->pattern;
+	if((offsets[offset/8] & (1 << offset%8)) != 0) {
+		return;
+	}
+	offsets[offset/8] |= 1 << offset%8;
 
-	case GAME_STATE_LOADING: {
-		renderLoadingState(renderer, game);
-	} break;
+	if(*pattern == '\0') {
+		if(nodes[node].word != 0 && nodes[node].seen != index->query) {
+			nodes[node].seen = index->query;
+			index->results[index->numResults++] = nodes[node].word - 1;
+		}
+		return;
+	}
 
-	case GAME_STATE_CHOOSING_LETTERS: {
-		renderChoosingLettersState(renderer, game);
-	} break;
+	if(*pattern == '*') {
+		// '*' matches no letters, or one letter and then the rest of the '*'
+		matchPattern(index, node, pattern+1);
+		for(Uint32 child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+			matchPattern(index, child, pattern);
+		}
+		return;
+	}
 
-	case GAME_STATE_RUNNING: {
-		renderRunningState(renderer, game);
-	} break;
+	for(Uint32 child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+		if(*pattern == '?' || nodes[child].letter == *pattern) {
+			matchPattern(index, child, pattern+1);
+		} else if(nodes[child].letter > *pattern) {
+			// the siblings are sorted, the letter isn't there
+			break;
+		}
+	}
+}
 
-	case GAME_STATE_ENDED: {
-		renderEndedState(renderer, game);
-	} break;
+bool runQuery(queryIndex_t *index, char *query)
+{
+	// normalized as the words, with consecutive '*' merged as they match the same
+	char normalized[QUERY_MAX_SIZE];
+	normalizeWord(query, normalized, sizeof(normalized));
+	bool pattern = false;
+	size_t len = 0;
+	for(size_t i = 0; normalized[i] != '\0'; i++) {
+		char c = normalized[i];
+		if(c == '*' && len > 0 && query[len-1] == '*') {
+			continue;
+		}
+		if(c == '?' || c == '*') {
+			pattern = true;
+		} else if(c < 'A' || c > 'Z') {
+			return false;
+		}
+		query[len++] = c;
+	}
+	query[len] = '\0';
+	if(len == 0) {
+		return false;
+	}
 
-	default: {
-	} break;
+	index->numResults = 0;
+	index->query++;
+	if(pattern) {
+		size_t offsetBytes = (len+1 + 7) / 8;
+		size_t visitedSize = index->numNodes * offsetBytes;
+		if(visitedSize > index->visitedSize) {
+			free(index->visited);
+			index->visited = malloc(visitedSize);
+			if(index->visited == NULL) {
+				fprintf(stderr, "Error: couldn't allocate the query\n");
+				exit(EXIT_FAILURE);
+			}
+			index->visitedSize = visitedSize;
+		}
+		index->pattern = query;
+		index->offsetBytes = offsetBytes;
+		matchPattern(index, 0, query);
+		// the trie is walked out of order by '*'
+		qsort(index->results, index->numResults, sizeof(Uint32), compareIds);
+	} else if(len < MAX_WORD_SIZE) {
+		findAnagrams(index, query);
+	}
+	return true;
+}
+
+int runQueries(int argc, char *argv[])
+{
+	assets_t *assets = calloc(1, sizeof(assets_t));
+	queryIndex_t *index = calloc(1, sizeof(queryIndex_t));
+	if(assets == NULL || index == NULL) {
+		fprintf(stderr, "Error: couldn't allocate the dictionary\n");
+		return EXIT_FAILURE;
+	}
+	jobPool_t *jobs = createJobPool(SDL_GetCPUCount());
+	loadDictionary(assets, jobs);
+	destroyJobPool(jobs);
+
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 start = SDL_GetPerformanceCounter();
+	buildQueryIndex(index, assets);
+	fprintf(stderr, "Index of %zu words and %zu trie nodes built in %.1f ms\n",
+			index->numSignatures, index->numNodes,
+			(double) (SDL_GetPerformanceCounter() - start) * 1000 / frequency);
+
+	// the queries are the arguments, or the lines of the standard input
+	char query[QUERY_MAX_SIZE];
+	size_t numQueries = 0;
+	Uint64 total = 0;
+	int status = EXIT_SUCCESS;
+	for(int i = 0; argc == 0 || i < argc; i++) {
+		if(argc == 0) {
+			if(fgets(query, sizeof(query), stdin) == NULL) {
+				break;
+			}
+			query[strcspn(query, "\r\n")] = '\0';
+			if(query[0] == '\0') {
+				continue;
+			}
+		} else {
+			snprintf(query, sizeof(query), "%s", argv[i]);
+		}
+
+		start = SDL_GetPerformanceCounter();
+		bool valid = runQuery(index, query);
+		total += SDL_GetPerformanceCounter() - start;
+		numQueries++;
+
+		if(!valid) {
+			fprintf(stderr, "Invalid query: %s (letters, '?' for any letter, '*' for any letters)\n", query);
+			status = EXIT_FAILURE;
+			continue;
+		}
+		fprintf(stdout, "%s (%zu):", query, index->numResults);
+		for(size_t j = 0; j < index->numResults; j++) {
+			fprintf(stdout, " %s", wordText(assets, index->results[j]));
+		}
+		fprintf(stdout, "\n");
+	}
 
+	if(numQueries > 0) {
+		fprintf(stderr, "%zu queries, %.2f us per query\n",
+				numQueries, (double) total * 1000000 / frequency / numQueries);
 	}
+
+	free(index->signatures);
+	free(index->nodes);
+	free(index->visited);
+	free(index->results);
+	free(index);
+	freeDictionary(assets);
+	free(assets);
+	return status;
 }